@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <celerity.h>
+
+// Measures how many commands per second the runtime is able to generate, transmit and execute.
+// Every task launches a trivial kernel with a one-to-one access pattern, so each task results in one COMPUTE command
+// per participating node without any data transfers. The runtime overhead thus dominates the execution time.
+
+constexpr size_t DEFAULT_NUM_TASKS = 10000;
+
+int main(int argc, char* argv[]) {
+	// Explicitly initialize here so we can use MPI functions below
+	celerity::runtime::init(&argc, &argv);
+
+	const size_t num_tasks = argc > 1 ? std::stoul(argv[1]) : DEFAULT_NUM_TASKS;
+	int num_nodes;
+	MPI_Comm_size(MPI_COMM_WORLD, &num_nodes);
+	// Make the buffer large enough so that every node receives a chunk
+	const size_t buf_size = 64 * static_cast<size_t>(num_nodes);
+
+	celerity::experimental::bench::log_user_config({{"numTasks", std::to_string(num_tasks)}});
+
+	{
+		celerity::distr_queue queue;
+		celerity::buffer<int, 1> buf(cl::sycl::range<1>(buf_size));
+
+		queue.submit([=](celerity::handler& cgh) {
+			auto b = buf.get_access<cl::sycl::access::mode::discard_write>(cgh, celerity::access::one_to_one<1>());
+			cgh.parallel_for<class init>(cl::sycl::range<1>(buf_size), [=](cl::sycl::item<1> item) { b[item] = 0; });
+		});
+
+		MPI_Barrier(MPI_COMM_WORLD);
+		const auto start = std::chrono::steady_clock::now();
+		celerity::experimental::bench::begin("main program");
+
+		for(size_t i = 0; i < num_tasks; ++i) {
+			queue.submit([=](celerity::handler& cgh) {
+				auto b = buf.get_access<cl::sycl::access::mode::read_write>(cgh, celerity::access::one_to_one<1>());
+				cgh.parallel_for<class increment>(cl::sycl::range<1>(buf_size), [=](cl::sycl::item<1> item) { b[item] += 1; });
+			});
+		}
+
+		queue.with_master_access([&](celerity::handler& cgh) {
+			auto result = buf.get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<1>(buf_size));
+
+			cgh.run([=]() {
+				celerity::experimental::bench::end("main program");
+				const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				const auto num_commands = num_tasks * static_cast<size_t>(num_nodes);
+				printf("%zu tasks on %d nodes in %.3fs: %.0f tasks/s, ~%.0f commands/s\n", num_tasks, num_nodes, seconds, num_tasks / seconds,
+				    num_commands / seconds);
+
+				for(size_t i = 0; i < buf_size; ++i) {
+					if(result[i] != static_cast<int>(num_tasks)) {
+						fprintf(stderr, "VERIFICATION FAILED for element %zu: %d != %zu\n", i, result[i], num_tasks);
+						break;
+					}
+				}
+			});
+		});
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -7,6 +7,7 @@
 #include <CL/sycl.hpp>
 
 #include "ranges.h"
+#include "staging_buffer_pool.h"
 #include "workaround.h"
 
 namespace celerity {
@@ -25,35 +26,53 @@ namespace detail {
 
 	struct raw_data_read_handle : raw_data_handle {
 		size_t linearized_data_size = 0;
+		// Number of bytes reserved in front of the linearized data (e.g. for a message header)
+		size_t prefix_size = 0;
 
-		void allocate(size_t byte_size) {
-			linearized_data_ptr = malloc(byte_size);
-			own_data = true;
+		void allocate(size_t byte_size, size_t prefix_size = 0) {
+			allocation = staging_buffer(prefix_size + byte_size);
+			linearized_data_ptr = allocation.get() + prefix_size;
+			this->prefix_size = prefix_size;
 		}
 
-		~raw_data_read_handle() {
-			if(linearized_data_ptr != nullptr && own_data) { free(linearized_data_ptr); }
-		}
+		/**
+		 * Returns a pointer to the reserved prefix, which is immediately followed by the linearized data.
+		 */
+		void* get_prefix_ptr() const { return allocation.get(); }
 
 	  private:
-		bool own_data = false;
+		staging_buffer allocation;
 	};
 
 	class buffer_storage_base {
 	  public:
 		/**
 		 * @param range The size of the buffer
+		 * @param element_size The size of a single buffer element, in bytes
 		 */
-		buffer_storage_base(cl::sycl::range<3> range) : range(range) {}
+		buffer_storage_base(cl::sycl::range<3> range, size_t element_size) : range(range), element_size(element_size) {}
 
 		cl::sycl::range<3> get_range() const { return range; }
 
-		virtual std::shared_ptr<raw_data_read_handle> get_data(cl::sycl::queue& queue, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range) = 0;
+		size_t get_element_size() const { return element_size; }
+
+		/**
+		 * @param prefix_size Number of bytes to reserve in front of the returned data, see raw_data_read_handle::get_prefix_ptr().
+		 */
+		virtual std::shared_ptr<raw_data_read_handle> get_data(
+		    cl::sycl::queue& queue, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range, size_t prefix_size = 0) = 0;
+
+		/**
+		 * Like ::get_data(), but copies the linearized data to @p dst instead, which has to be large enough to hold it.
+		 */
+		virtual void get_data_into(cl::sycl::queue& queue, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range, void* dst) = 0;
+
 		virtual void set_data(cl::sycl::queue& queue, const raw_data_handle& dh) = 0;
 		virtual ~buffer_storage_base() = default;
 
 	  private:
 		cl::sycl::range<3> range;
+		size_t element_size;
 	};
 
 	// FIXME: Remove this
@@ -65,7 +84,7 @@ namespace detail {
 	template <typename DataT, int Dims>
 	class buffer_storage : public virtual buffer_storage_base {
 	  public:
-		buffer_storage(cl::sycl::range<Dims> range) : buffer_storage_base(detail::range_cast<3>(range)) {
+		buffer_storage(cl::sycl::range<Dims> range) : buffer_storage_base(detail::range_cast<3>(range), sizeof(DataT)) {
 			// TODO: Especially on master node it is likely overkill to initialize all buffers eagerly
 			sycl_buf = std::make_unique<cl::sycl::buffer<DataT, Dims>>(detail::range_cast<Dims>(get_range()));
 		}
@@ -75,22 +94,31 @@ namespace detail {
 		 */
 		cl::sycl::buffer<DataT, Dims>& get_sycl_buffer() { return *sycl_buf; }
 
-		std::shared_ptr<raw_data_read_handle> get_data(cl::sycl::queue& queue, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range) override {
-			assert(Dims > 1 || (offset[1] == 0 && range[1] == 1));
-			assert(Dims > 2 || (offset[2] == 0 && range[2] == 1));
-
+		std::shared_ptr<raw_data_read_handle> get_data(
+		    cl::sycl::queue& queue, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range, size_t prefix_size = 0) override {
 			auto result = std::make_shared<raw_data_read_handle>();
 			result->range = range;
 			result->offset = offset;
 			result->linearized_data_size = sizeof(DataT) * range[0] * range[1] * range[2];
 
-			result->allocate(result->linearized_data_size);
+			result->allocate(result->linearized_data_size, prefix_size);
+			get_data_into(queue, offset, range, result->linearized_data_ptr);
+
+			return result;
+		}
+
+		void get_data_into(cl::sycl::queue& queue, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range, void* dst) override {
+			assert(Dims > 1 || (offset[1] == 0 && range[1] == 1));
+			assert(Dims > 2 || (offset[2] == 0 && range[2] == 1));
+
 			// TODO: Ideally we'd not wait here and instead return some sort of async handle that can be waited upon
 			auto buf = get_sycl_buffer();
 			// Explicit memory operations appear to be broken in ComputeCpp as of version 1.0.5
 			// As a workaround we create a temporary buffer and copy the contents manually.
+			// The temporary buffer uses the destination memory directly, so the data isn't copied yet another time.
 #if WORKAROUND(COMPUTECPP, 1, 0, 5)
-			cl::sycl::buffer<DataT, Dims> tmp_dst_buf(reinterpret_cast<DataT*>(result->linearized_data_ptr), cl::sycl::range<Dims>(range));
+			cl::sycl::buffer<DataT, Dims> tmp_dst_buf(
+			    reinterpret_cast<DataT*>(dst), cl::sycl::range<Dims>(range), {cl::sycl::property::buffer::use_host_ptr{}});
 			const auto dim_offset = cl::sycl::id<Dims>(offset);
 			auto event = queue.submit([&](cl::sycl::handler& cgh) {
 				auto src_acc = buf.template get_access<cl::sycl::access::mode::read>(cgh, cl::sycl::range<Dims>(range), dim_offset);
@@ -101,12 +129,10 @@ namespace detail {
 #else
 			auto event = queue.submit([&](cl::sycl::handler& cgh) {
 				auto acc = buf.template get_access<cl::sycl::access::mode::read>(cgh, detail::range_cast<Dims>(range), detail::id_cast<Dims>(offset));
-				cgh.copy(acc, reinterpret_cast<DataT*>(result->linearized_data_ptr));
+				cgh.copy(acc, reinterpret_cast<DataT*>(dst));
 			});
 #endif
 			event.wait();
-
-			return result;
 		}
 
 		void set_data(cl::sycl::queue& queue, const raw_data_handle& dh) override {
@@ -115,7 +141,8 @@ namespace detail {
 			// Explicit memory operations appear to be broken in ComputeCpp as of version 1.0.5
 			// As a workaround we create a temporary buffer and copy the contents manually.
 #if WORKAROUND(COMPUTECPP, 1, 0, 5)
-			cl::sycl::buffer<DataT, Dims> tmp_src_buf(reinterpret_cast<DataT*>(dh.linearized_data_ptr), cl::sycl::range<Dims>(dh.range));
+			cl::sycl::buffer<DataT, Dims> tmp_src_buf(
+			    reinterpret_cast<DataT*>(dh.linearized_data_ptr), cl::sycl::range<Dims>(dh.range), {cl::sycl::property::buffer::use_host_ptr{}});
 			const auto dim_offset = cl::sycl::id<Dims>(dh.offset);
 			auto event = queue.submit([&](cl::sycl::handler& cgh) {
 				auto src_acc = tmp_src_buf.template get_access<cl::sycl::access::mode::read>(cgh);
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <future>
 #include <list>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <mpi.h>
 
@@ -10,6 +14,9 @@
 #include "command.h"
 #include "logger.h"
 #include "mpi_support.h"
+#include "rma_transport.h"
+#include "shared_memory_transport.h"
+#include "staging_buffer_pool.h"
 #include "types.h"
 
 namespace celerity {
@@ -21,62 +28,231 @@ namespace detail {
 			bool complete = false;
 		};
 
-		buffer_transfer_manager(std::shared_ptr<logger> transfer_logger) : transfer_logger(transfer_logger) {}
+		/**
+		 * PUSHes of at least this many bytes are staged (i.e., copied to the host and linearized) in a worker thread, so they don't block
+		 * the executor. Handing a PUSH off to another thread has a fixed cost, which likely outweighs the benefit for small PUSHes.
+		 * The default is a heuristic rather than a measured value, and may need tuning for a given platform.
+		 */
+		static constexpr size_t default_async_push_threshold = 256 * 1024;
+
+		/**
+		 * PUSHes of at most this many bytes are not sent right away. Instead, all such PUSHes to the same node are coalesced into a single message
+		 * when ::send_aggregated_pushes() is called, which considerably reduces the message rate for fine-grained (e.g. halo) transfers.
+		 * Both sender and receiver derive from this whether a transfer is aggregated, so it can't be configured per instance.
+		 */
+		static constexpr size_t max_aggregated_push_size = 4 * 1024;
+
+		/**
+		 * Aggregated messages are kept below this size, so they can still be sent eagerly by MPI.
+		 */
+		static constexpr size_t max_aggregate_message_size = 64 * 1024;
+
+		/**
+		 * Size of the shared memory segment each process allocates for transfers to other processes on the same host.
+		 */
+		static constexpr size_t default_shm_segment_size = 64 * 1024 * 1024;
+
+		/**
+		 * When using one-sided transfers, the size of the receive ring each node provides for every other node (see rma_transport).
+		 * Larger transfers are sent point-to-point.
+		 */
+		static constexpr size_t rma_region_size = 4 * 1024 * 1024;
+
+		/**
+		 * Construction is collective over all processes in MPI_COMM_WORLD, see shared_memory_transport and rma_transport.
+		 *
+		 * @param use_rma Whether to transfer data between hosts using one-sided MPI operations. This has to be the same on all nodes.
+		 */
+		buffer_transfer_manager(std::shared_ptr<logger> transfer_logger, size_t shm_segment_size = default_shm_segment_size, bool use_rma = false,
+		    size_t async_push_threshold = default_async_push_threshold);
 
 		std::shared_ptr<const transfer_handle> push(const command_pkg& pkg);
+
+		/**
+		 * @brief Sends all small PUSHes that have been collected since the last call, one message per target node.
+		 *
+		 * This should be called after all PUSHes that became ready at the same time have been started.
+		 */
+		void send_aggregated_pushes();
+
+		/**
+		 * @brief Posts the receive for an AWAIT_PUSH command ahead of time, so the incoming data doesn't have to be buffered by MPI.
+		 *
+		 * This should be called as soon as the command is known. The data is only written to the buffer once ::await_push() has been called.
+		 */
+		void prepare_await_push(const command_pkg& pkg);
+
 		std::shared_ptr<const transfer_handle> await_push(const command_pkg& pkg);
 
 		/**
-		 * @brief Polls for incoming transfers and updates the status of existing ones.
+		 * @brief Updates the status of all pending transfers.
+		 *
+		 * @returns Whether any progress has been made, i.e. a transfer has been started or completed.
 		 */
-		void poll();
+		bool poll();
+
+		/**
+		 * @brief Returns the total size of all outgoing transfers that have not yet been completed.
+		 */
+		size_t get_outgoing_bytes() const { return outgoing_bytes; }
 
 	  private:
-		struct data_header {
+		/**
+		 * How the data of a PUSH is transferred. This is derived from the source, target and size of the transfer only, so both sides agree on it.
+		 */
+		enum class transport {
+			AGGREGATED,     // Sent along with other small PUSHes to the same node, see ::send_aggregated_pushes()
+			SHARED_MEMORY,  // Written into the sender's shared memory segment, with only the header being sent, see shared_memory_transport
+			RMA,            // Written into the receiver's window using one-sided operations, see rma_transport
+			POINT_TO_POINT, // Sent as a single message, using a tag derived from the PUSH command
+		};
+
+		/**
+		 * Data transfers are sent as a single contiguous message, consisting of this header followed by the payload.
+		 * Aggregated messages consist of a sequence of such parts, with each payload padded to preserve alignment (see ::get_aggregate_part_size()).
+		 */
+		struct alignas(std::max_align_t) data_header {
 			buffer_id bid;
 			command_subrange subrange;
 			command_id push_cid;
+			// Size of the payload, in bytes
+			size_t size;
+			// If the payload has been transferred through shared memory, its offset in the sender's segment (the message then only
+			// consists of the header). Otherwise ::inline_payload.
+			size_t shm_offset;
 		};
+		static_assert(sizeof(data_header) % alignof(std::max_align_t) == 0, "Payload following the data header must be suitably aligned");
+
+		static constexpr size_t inline_payload = static_cast<size_t>(-1);
+
+		static constexpr size_t get_aggregate_part_size(size_t payload_size) {
+			return sizeof(data_header) + (payload_size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+		}
 
 		struct transfer_in {
-			MPI_Request request;
+			node_id source;
+			// The PUSH whose data is expected. If another transfer uses the same tag, the receive may be matched by its data instead.
+			command_id push_cid;
+			// Only valid once the transfer has been received
 			data_header header;
-			std::vector<char> data;
-			mpi_support::single_use_data_type data_type;
+			// Header and payload, as received. This is deliberately left uninitialized, as it is overwritten by the receive anyway.
+			staging_buffer message;
+
+			char* get_payload() { return message.get() + sizeof(data_header); }
 		};
 
 		struct incoming_transfer_handle : transfer_handle {
 			std::unique_ptr<transfer_in> transfer;
+			bool received = false;
+			// Whether ::await_push() has been called, i.e. the data may be written to the buffer
+			bool requested = false;
 		};
 
+		/**
+		 * Outgoing transfers go through two stages: The data is first staged, i.e. copied from the device and linearized into host memory,
+		 * after which it is sent. Large transfers are staged asynchronously, in which case ::staged_data remains valid until that has completed.
+		 *
+		 * Transfers to nodes on the same host are staged directly into shared memory instead, and only the header is sent.
+		 * If there currently isn't enough space in the shared memory segment, staging is postponed until there is.
+		 * Likewise, one-sided transfers are only sent once there is enough space in the target's ring.
+		 */
 		struct transfer_out {
 			std::shared_ptr<transfer_handle> handle;
-			MPI_Request request;
-			data_header header;
-			mpi_support::single_use_data_type data_type;
+			command_pkg pkg;
+			// Size of the payload, in bytes
+			size_t size;
+			transport tp;
+			size_t shm_offset = inline_payload;
+			rma_transport::entry rma_entry;
+			std::future<std::shared_ptr<detail::raw_data_read_handle>> staged_data;
+			std::shared_ptr<detail::raw_data_read_handle> data_handle;
+			data_header shm_header;
 
-			transfer_out(std::shared_ptr<detail::raw_data_read_handle> data_handle) : data_handle(std::move(data_handle)) {}
-			void* get_raw_ptr() const { return data_handle->linearized_data_ptr; }
+			transfer_out(const command_pkg& pkg, size_t size, transport tp) : pkg(pkg), size(size), tp(tp) {}
+			// Unless the payload is in shared memory, the header is stored in the space reserved in front of it
+			void* get_message_ptr() { return tp == transport::SHARED_MEMORY ? static_cast<void*>(&shm_header) : data_handle->get_prefix_ptr(); }
+			size_t get_message_size() const { return sizeof(data_header) + (tp == transport::SHARED_MEMORY ? 0 : size); }
+		};
 
-		  private:
-			std::shared_ptr<detail::raw_data_read_handle> data_handle;
+		/**
+		 * A message containing the data of multiple small PUSHes to the same node. PUSHes are appended until the message is sent.
+		 */
+		struct aggregate_out {
+			node_id target;
+			staging_buffer message{max_aggregate_message_size};
+			size_t message_size = 0;
+			// Total size of all payloads, in bytes
+			size_t size = 0;
+			std::vector<std::shared_ptr<transfer_handle>> handles;
+
+			explicit aggregate_out(node_id target) : target(target) {}
 		};
 
-		std::list<std::unique_ptr<transfer_in>> incoming_transfers;
-		std::list<std::unique_ptr<transfer_out>> outgoing_transfers;
+		// Transfers whose receive has been posted, but not yet completed
+		mpi_support::request_set<std::shared_ptr<incoming_transfer_handle>> incoming_transfers;
+		// The tags of all posted receives (see mpi_support::get_data_transfer_tag()) and the PUSH each one is posted for, by source node
+		std::unordered_map<node_id, std::unordered_map<int, command_id>> posted_transfer_tags;
+		// PUSHes whose receive hasn't been posted because their tag is already in use, by source node and tag. See ::receive_probed_transfers().
+		std::unordered_map<node_id, std::unordered_map<int, std::unordered_set<command_id>>> probed_transfers;
+		// Transfers that are still being staged, or are waiting for space in shared memory or the target's ring
+		std::list<std::unique_ptr<transfer_out>> unsent_transfers;
+		mpi_support::request_set<std::unique_ptr<transfer_out>> outgoing_transfers;
+		size_t outgoing_bytes = 0;
 
-		// Here we store two types of handles:
-		//  - Incoming pushes that have not yet been requested through ::await_push
-		//  - Still outstanding pushes that have been requested through ::await_push
+		// Aggregates that are still being filled, by target node
+		std::unordered_map<node_id, std::unique_ptr<aggregate_out>> pending_aggregates;
+		mpi_support::request_set<std::unique_ptr<aggregate_out>> outgoing_aggregates;
+
+		/**
+		 * Handles of all AWAIT_PUSHes that haven't been requested through ::await_push yet, by the id of the corresponding PUSH.
+		 * This includes prepared AWAIT_PUSHes as well as aggregated transfers that were received before their AWAIT_PUSH was known.
+		 */
 		std::unordered_map<command_id, std::shared_ptr<incoming_transfer_handle>> push_blackboard;
 
+		// Handles of all prepared AWAIT_PUSHes without a posted receive (i.e., aggregated and one-sided transfers), whose data hasn't arrived yet
+		std::unordered_map<command_id, std::shared_ptr<incoming_transfer_handle>> pending_unposted_transfers;
+
 		std::shared_ptr<logger> transfer_logger;
+		const size_t async_push_threshold;
+		const node_id local_nid;
+		shared_memory_transport shm_transport;
+		std::unique_ptr<rma_transport> rma;
+
+		transport get_transport(node_id source, node_id target, size_t data_size) const;
+
+		bool update_incoming_transfers();
+		bool receive_aggregated_transfers();
+		/**
+		 * Receives the data for PUSHes that share their tag with another transfer from the same node. These are matched through MPI_Improbe,
+		 * and then assigned to their AWAIT_PUSH based on the header.
+		 */
+		bool receive_probed_transfers();
+		/**
+		 * Hands data that arrived without a posted receive, consisting of a header followed by the payload, to the corresponding AWAIT_PUSH.
+		 */
+		void deliver_unposted_transfer(const char* message);
+		/**
+		 * Like ::deliver_unposted_transfer(), but @p message may also be the header of a transfer through shared memory from node @p source.
+		 */
+		void deliver_received_transfer(node_id source, const char* message);
+		bool update_outgoing_transfers();
+
+		/**
+		 * Copies the data to @p shm_payload if it is transferred through shared memory, or to a new staging buffer otherwise.
+		 */
+		static std::shared_ptr<detail::raw_data_read_handle> stage_push_data(const push_data& data, char* shm_payload);
+		void start_staging(transfer_out& transfer);
+		/**
+		 * Advances @p transfer as far as possible, sending it once it has been staged and all required space could be allocated.
+		 *
+		 * @returns Whether the transfer has been sent, in which case ownership has been moved to ::outgoing_transfers.
+		 */
+		bool try_send(std::unique_ptr<transfer_out>& transfer);
 
-		void poll_incoming_transfers();
-		void update_incoming_transfers();
-		void update_outgoing_transfers();
+		void aggregate_push(const command_pkg& pkg, size_t data_size, std::shared_ptr<transfer_handle> t_handle);
+		void send_aggregate(std::unique_ptr<aggregate_out> aggregate);
 
-		void write_data_to_buffer(transfer_in& transfer);
+		void write_data_to_buffer(const data_header& header, const char* payload);
 	};
 
 } // namespace detail
@@ -48,6 +48,8 @@ namespace detail {
 
 	struct compute_data {
 		command_subrange subrange;
+		// Number of directly following tasks (tid + 1, tid + 2, ...) whose kernels are executed on the same subrange as part of this command
+		size_t fused_tasks;
 	};
 
 	struct master_access_data {};
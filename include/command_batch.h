@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include "command.h"
+#include "types.h"
+
+namespace celerity {
+namespace detail {
+
+	/**
+	 * Serializes a sequence of commands, along with their dependencies, into a single contiguous buffer.
+	 * This allows sending all commands for a node that result from a single flush as one message.
+	 *
+	 * Commands use a compact variable-length encoding: All integers are written as LEB128 varints, command ids (including
+	 * dependencies) are delta-encoded relative to the previous command in the batch, and subranges only include as many
+	 * dimensions as are actually used. For typical ids and dependencies this requires only a few bytes per value.
+	 */
+	class command_batch {
+	  public:
+		void add(const command_pkg& pkg, const std::vector<command_id>& dependencies);
+
+		bool empty() const { return data.empty(); }
+		size_t get_command_count() const { return command_count; }
+
+		const std::vector<unsigned char>& get_data() const { return data; }
+
+		/**
+		 * @brief Moves the encoded data out of the batch, leaving the batch empty.
+		 */
+		std::vector<unsigned char> take_data();
+
+		/**
+		 * @brief Hands a buffer previously obtained through ::take_data() back to the batch, so its capacity can be reused.
+		 */
+		void recycle(std::vector<unsigned char> buffer);
+
+		/**
+		 * @brief Decodes a batch from @p data, invoking @p cb with each command and its dependencies in the order they were added.
+		 *
+		 * @param dependencies Buffer that receives the dependencies of each command before invoking the callback, reused between commands.
+		 */
+		template <typename Callback>
+		static void decode(const unsigned char* data, size_t size, std::vector<command_id>& dependencies, Callback&& cb) {
+			const unsigned char* const end = data + size;
+			command_id previous_cid = 0;
+			command_pkg pkg;
+			while(data < end) {
+				decode_command(data, end, previous_cid, pkg, dependencies);
+				cb(pkg, dependencies);
+			}
+		}
+
+	  private:
+		std::vector<unsigned char> data;
+		size_t command_count = 0;
+		command_id previous_cid = 0;
+
+		static void decode_command(
+		    const unsigned char*& pos, const unsigned char* end, command_id& previous_cid, command_pkg& pkg, std::vector<command_id>& dependencies);
+	};
+
+} // namespace detail
+} // namespace celerity
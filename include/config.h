@@ -2,6 +2,7 @@
 
 #include <boost/optional.hpp>
 #include <string>
+#include <vector>
 
 #include "logger.h"
 
@@ -13,6 +14,13 @@ namespace detail {
 		size_t device_id;
 	};
 
+	struct master_participation_config {
+		// Whether the master node's share of work should be derived from how busy its scheduler is.
+		bool automatic;
+		// Otherwise, the master node's weight relative to all other nodes in [0, 1]. Zero excludes the master node from computing.
+		double weight;
+	};
+
 	class config {
 	  public:
 		/**
@@ -38,11 +46,71 @@ namespace detail {
 		boost::optional<bool> get_enable_device_profiling() const { return enable_device_profiling; };
 		boost::optional<size_t> get_forced_work_group_size() const { return forced_work_group_size; };
 
+		/**
+		 * Returns the number of chunks each node receives when splitting compute commands, as set by the CELERITY_CHUNKS_PER_NODE environment variable.
+		 */
+		boost::optional<size_t> get_chunks_per_node() const { return chunks_per_node; };
+
+		/**
+		 * Returns whether compute commands should be split according to the measured throughput of each node,
+		 * as set by the CELERITY_LOAD_BALANCING environment variable.
+		 */
+		boost::optional<bool> get_enable_load_balancing() const { return enable_load_balancing; };
+
+		/**
+		 * Returns the weight of the previous throughput estimate when incorporating a new measurement, as set by CELERITY_LB_DAMPING.
+		 */
+		boost::optional<double> get_load_balancing_damping() const { return load_balancing_damping; };
+
+		/**
+		 * Returns the fixed per-node weights used for splitting compute commands, as set by the CELERITY_SPLIT_WEIGHTS environment variable.
+		 * The variable has the form "W0 W1 ... Wn", with one non-negative weight for each node, starting with the master node.
+		 */
+		boost::optional<std::vector<double>> get_split_weights() const { return split_weights; };
+
+		/**
+		 * Returns the maximum number of consecutive compute tasks that can be fused into a single command per node,
+		 * as set by the CELERITY_TASK_FUSION environment variable.
+		 */
+		boost::optional<size_t> get_max_fused_tasks() const { return max_fused_tasks; };
+
+		/**
+		 * Returns how much work the master node receives when splitting compute commands, as set by the CELERITY_MASTER_PARTICIPATION
+		 * environment variable. The variable is either "exclude", "auto" or a weight in [0, 1], relative to all other nodes.
+		 */
+		boost::optional<master_participation_config> get_master_participation() const { return master_participation; };
+
+		/**
+		 * Returns the size of the shared memory segment (in bytes) used for transfers to other nodes on the same host, as set by the
+		 * CELERITY_SHM_SEGMENT_SIZE environment variable (in MiB). Zero disables transfers through shared memory.
+		 */
+		boost::optional<size_t> get_shm_segment_size() const { return shm_segment_size; };
+
+		/**
+		 * Returns whether data should be transferred between hosts using one-sided MPI operations, as set by the CELERITY_RMA_TRANSFERS
+		 * environment variable. This has to be set identically for all nodes.
+		 */
+		boost::optional<bool> get_enable_rma_transfers() const { return enable_rma_transfers; };
+
+		/**
+		 * Returns the maximum number of COMPUTE commands each node executes concurrently, as set by the CELERITY_MAX_COMPUTE_JOBS environment variable.
+		 */
+		boost::optional<size_t> get_max_compute_jobs() const { return max_compute_jobs; };
+
 	  private:
 		log_level log_lvl;
 		boost::optional<device_config> device_cfg;
 		boost::optional<bool> enable_device_profiling;
 		boost::optional<size_t> forced_work_group_size;
+		boost::optional<size_t> chunks_per_node;
+		boost::optional<bool> enable_load_balancing;
+		boost::optional<double> load_balancing_damping;
+		boost::optional<std::vector<double>> split_weights;
+		boost::optional<size_t> max_fused_tasks;
+		boost::optional<master_participation_config> master_participation;
+		boost::optional<size_t> shm_segment_size;
+		boost::optional<bool> enable_rma_transfers;
+		boost::optional<size_t> max_compute_jobs;
 	};
 
 } // namespace detail
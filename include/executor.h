@@ -1,10 +1,17 @@
 #pragma once
 
+#include <cassert>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 
 #include "buffer_transfer_manager.h"
 #include "logger.h"
+#include "spsc_queue.h"
+#include "transport.h"
 #include "worker_job.h"
 
 namespace celerity {
@@ -35,12 +42,131 @@ namespace detail {
 		duration_metric compute_idle;
 		// How much time is spent without any jobs (excluding initial idle)
 		duration_metric starvation;
+		// How much time the executor thread spends sleeping because no progress could be made
+		duration_metric backoff;
 	};
 
+	/**
+	 * Adaptive backoff for the executor loop. While no progress is being made, the loop first keeps spinning for a few iterations,
+	 * then starts yielding and finally sleeps for exponentially increasing durations.
+	 *
+	 * Sleeping is ended early by ::notify(), which is used for commands passed to the executor directly. Other events (such as incoming
+	 * messages or completed transfers) are only noticed once the sleep times out, so its duration is capped well below the interval at which
+	 * commands typically arrive. Note that on Linux, timer slack adds another 50us or so to every sleep.
+	 */
+	class idle_backoff {
+	  public:
+		static constexpr size_t spin_iterations = 64;
+		static constexpr size_t yield_iterations = 64;
+		static constexpr std::chrono::microseconds max_sleep{20};
+
+		void reset() { idle_iterations = 0; }
+
+		/**
+		 * @brief Called for every loop iteration that didn't make any progress. Sleep times are accumulated into @p metric.
+		 */
+		void idle(duration_metric& metric);
+
+		/**
+		 * @brief Ends the current sleep right away, or skips the next one if the loop isn't sleeping right now. May be called from any thread.
+		 */
+		void notify();
+
+	  private:
+		size_t idle_iterations = 0;
+		std::mutex mutex;
+		std::condition_variable wake_up;
+		bool notified = false;
+	};
+
+	/**
+	 * Decides whether a job that has become ready may be started right away.
+	 *
+	 * Transfers are always admitted (other nodes may be blocked on them), with the exception of PUSHes while the outgoing data
+	 * staged for sending exceeds a memory budget. COMPUTE jobs are bounded by how many kernels the device is expected to process concurrently.
+	 * As there is no portable way of querying this from SYCL, the limit can be configured through CELERITY_MAX_COMPUTE_JOBS.
+	 */
+	class admission_control {
+	  public:
+		static constexpr size_t default_max_running_compute_jobs = 16;
+		static constexpr size_t default_max_outgoing_transfer_bytes = 256 * 1024 * 1024;
+
+		admission_control(
+		    size_t max_running_compute_jobs = default_max_running_compute_jobs, size_t max_outgoing_transfer_bytes = default_max_outgoing_transfer_bytes)
+		    : max_running_compute_jobs(max_running_compute_jobs), max_outgoing_transfer_bytes(max_outgoing_transfer_bytes) {}
+
+		bool admit(command cmd, size_t running_compute_jobs, size_t outgoing_transfer_bytes) const;
+
+	  private:
+		size_t max_running_compute_jobs;
+		size_t max_outgoing_transfer_bytes;
+	};
+
+	/**
+	 * A command (along with its dependencies) that is passed directly to the executor on the same node, bypassing the transport.
+	 * Entries with ::ends_flush set carry no command, but mark that all commands of the current flush have been passed.
+	 */
+	struct local_command {
+		command_pkg pkg;
+		std::vector<command_id> dependencies;
+		bool ends_flush = false;
+	};
+
+	using local_command_queue = spsc_queue<local_command>;
+
 	class executor {
 	  public:
+		using throughput_callback = std::function<void(node_id, size_t, std::chrono::microseconds)>;
+		using completion_callback = std::function<void(node_id, command_id)>;
+
+		/**
+		 * @param ctrl_transport Used for receiving command batches and sending progress reports.
+		 * @param btm Used for executing PUSH and AWAIT_PUSH commands. May be null if there are none, which allows running executors
+		 *            without MPI (e.g. multiple simulated nodes in one process, using a loopback_transport).
+		 * @param report_throughput Whether to send the duration of completed COMPUTE jobs to the master node (used for load balancing).
+		 * @param max_running_compute_jobs How many COMPUTE jobs may run concurrently, see admission_control.
+		 */
 		// TODO: Try to decouple this more.
-		executor(device_queue& queue, task_manager& tm, std::shared_ptr<logger> execution_logger);
+		executor(device_queue& queue, task_manager& tm, std::shared_ptr<logger> execution_logger, std::unique_ptr<transport> ctrl_transport,
+		    std::unique_ptr<buffer_transfer_manager> btm, bool report_throughput = false,
+		    size_t max_running_compute_jobs = admission_control::default_max_running_compute_jobs);
+
+		/**
+		 * @brief Sets a callback that is invoked (on the executor thread) for each throughput report received from any node.
+		 *
+		 * This is only meaningful on the master node, and has to be called before ::startup().
+		 */
+		void set_throughput_callback(throughput_callback cb) { throughput_cb = std::move(cb); }
+
+		/**
+		 * @brief Sets a callback that is invoked (on the executor thread) whenever a node reports that all of its commands with ids below
+		 * the given one have completed.
+		 *
+		 * This is only meaningful on the master node, and has to be called before ::startup().
+		 */
+		void set_completion_callback(completion_callback cb) { completion_cb = std::move(cb); }
+
+		/**
+		 * @brief Makes the executor receive its commands through ::enqueue_local_command() instead of the transport.
+		 *
+		 * This is used on the master node, where the scheduler runs in the same process. Has to be called before ::startup().
+		 */
+		void enable_local_commands();
+
+		/**
+		 * @brief Passes a command directly to this executor. Must only be called from a single (producer) thread at a time.
+		 *
+		 * Blocks while the queue of local commands is full.
+		 */
+		void enqueue_local_command(const command_pkg& pkg, const std::vector<command_id>& dependencies);
+
+		/**
+		 * @brief Informs the executor that all local commands of the current flush have been passed through ::enqueue_local_command().
+		 *
+		 * Commands within a flush don't arrive in order of their ids, so the completed watermark only takes them into account once
+		 * the flush is complete. Must be called from the same thread as ::enqueue_local_command().
+		 */
+		void end_local_flush();
 
 		void startup();
 
@@ -57,24 +183,181 @@ namespace detail {
 		std::thread exec_thrd;
 		std::unordered_map<command, size_t> job_count_by_cmd;
 
+		class job_pool_base {
+		  public:
+			virtual ~job_pool_base() = default;
+			virtual void release(worker_job* job) = 0;
+		};
+
+		struct pooled_job_deleter {
+			job_pool_base* pool;
+			void operator()(worker_job* job) const { pool->release(job); }
+		};
+
+		using pooled_job_ptr = std::unique_ptr<worker_job, pooled_job_deleter>;
+
+		/**
+		 * Recycles the storage of completed jobs of a given type, so that we don't have to go through the allocator for every command.
+		 * Jobs are only ever created and destroyed on the executor thread, so no synchronization is required.
+		 */
+		template <typename Job>
+		class job_pool final : public job_pool_base {
+		  public:
+			job_pool() = default;
+			job_pool(const job_pool&) = delete;
+			job_pool& operator=(const job_pool&) = delete;
+
+			~job_pool() override {
+				for(void* storage : free_storage) {
+					::operator delete(storage);
+				}
+			}
+
+			template <typename... Args>
+			pooled_job_ptr acquire(Args&&... args) {
+				void* storage;
+				if(free_storage.empty()) {
+					storage = ::operator new(sizeof(Job));
+				} else {
+					storage = free_storage.back();
+					free_storage.pop_back();
+				}
+				try {
+					return pooled_job_ptr(new(storage) Job(std::forward<Args>(args)...), pooled_job_deleter{this});
+				} catch(...) {
+					free_storage.push_back(storage);
+					throw;
+				}
+			}
+
+			void release(worker_job* job) override {
+				const auto typed_job = static_cast<Job*>(job);
+				typed_job->~Job();
+				free_storage.push_back(typed_job);
+			}
+
+		  private:
+			std::vector<void*> free_storage;
+		};
+
+		// Pools have to outlive all jobs, so they are declared first
+		job_pool<push_job> push_job_pool;
+		job_pool<await_push_job> await_push_job_pool;
+		job_pool<compute_job> compute_job_pool;
+		job_pool<master_access_job> master_access_job_pool;
+
 		// Jobs are identified by the command id they're processing
 
 		struct job_handle {
-			std::unique_ptr<worker_job> job;
+			command_id cid;
+			pooled_job_ptr job;
 			command cmd;
 			std::vector<command_id> dependants;
-			size_t unsatisfied_dependencies;
+			size_t unsatisfied_dependencies = 0;
+
+			// Links for the job_list this job is currently part of
+			job_handle* prev = nullptr;
+			job_handle* next = nullptr;
+		};
+
+		/**
+		 * Intrusive doubly linked list of job handles. Every job is part of exactly one list (blocked, ready or running) at any time,
+		 * which allows moving it between lists in constant time. Handles are stored in an unordered_map, so their addresses are stable.
+		 */
+		class job_list {
+		  public:
+			bool empty() const { return head == nullptr; }
+			job_handle* front() const { return head; }
+
+			void push_back(job_handle& handle) {
+				assert(handle.prev == nullptr && handle.next == nullptr && head != &handle);
+				handle.prev = tail;
+				if(tail != nullptr) {
+					tail->next = &handle;
+				} else {
+					head = &handle;
+				}
+				tail = &handle;
+			}
+
+			void erase(job_handle& handle) {
+				if(handle.prev != nullptr) {
+					handle.prev->next = handle.next;
+				} else {
+					head = handle.next;
+				}
+				if(handle.next != nullptr) {
+					handle.next->prev = handle.prev;
+				} else {
+					tail = handle.prev;
+				}
+				handle.prev = handle.next = nullptr;
+			}
+
+		  private:
+			job_handle* head = nullptr;
+			job_handle* tail = nullptr;
 		};
 
 		std::unordered_map<command_id, job_handle> jobs;
+		// Jobs that are waiting for some of their dependencies to complete
+		job_list blocked_jobs;
+		// Jobs whose dependencies have all completed, but which have not been started yet (e.g. because they weren't admitted).
+		// PUSH jobs are kept separately, as they are always started before any other ready jobs.
+		job_list ready_pushes;
+		job_list ready_jobs;
+		job_list running_jobs;
+
+		// Dependants lists of completed jobs, kept around to reuse their capacity
+		std::vector<std::vector<command_id>> spare_dependants;
+		// Receive buffers for incoming messages (command batches and progress reports) and the dependencies of each command therein
+		std::vector<unsigned char> received_message;
+		std::vector<command_id> received_dependencies;
+
+		static constexpr size_t local_command_queue_capacity = 4096;
+		std::unique_ptr<local_command_queue> local_commands;
+		local_command received_local_command;
 
+		admission_control admission;
 		executor_metrics metrics;
+		idle_backoff backoff;
 		bool first_command_received = false;
 
+		// Progress reports are sent to the master node whenever there is something new to report and the previous report has been delivered.
+		// They contain aggregated COMPUTE job durations (if throughput reporting is enabled), as well as the completed watermark.
+		struct progress_report {
+			size_t work_items;
+			std::chrono::microseconds::rep duration;
+			size_t completed_watermark;
+		};
+
+		node_id local_nid;
+		const bool report_throughput;
+		progress_report pending_report = {0, 0, 0};
+		std::vector<unsigned char> report_buffer;
+		std::unique_ptr<transport> ctrl_transport;
+		throughput_callback throughput_cb;
+		completion_callback completion_cb;
+
+		// Min-heap of the ids of all received commands, which are lazily removed once completed. Together with the
+		// (exclusive) upper bound of received ids, this allows us to compute the id below which all commands have completed.
+		// Commands within a flush (i.e., a command batch) can arrive in any order, so the upper bound is only advanced once
+		// all commands of a flush have been received.
+		std::vector<command_id> received_cids;
+		command_id received_cids_end = 0;
+		command_id pending_cids_end = 0;
+		command_id reported_watermark = 0;
+
 		template <typename Job, typename... Args>
-		void create_job(const command_pkg& pkg, const std::vector<command_id>& dependencies, Args&&... args) {
-			auto logger = execution_logger->create_context({{"task", std::to_string(pkg.tid)}, {"job", std::to_string(pkg.cid)}});
-			jobs[pkg.cid] = {std::make_unique<Job>(pkg, logger, std::forward<Args>(args)...), pkg.cmd, {}, 0};
+		void create_job(const command_pkg& pkg, const std::vector<command_id>& dependencies, job_pool<Job>& pool, Args&&... args) {
+			auto& handle = jobs[pkg.cid];
+			handle.cid = pkg.cid;
+			handle.job = pool.acquire(pkg, execution_logger, std::forward<Args>(args)...);
+			handle.cmd = pkg.cmd;
+			if(!spare_dependants.empty()) {
+				handle.dependants = std::move(spare_dependants.back());
+				spare_dependants.pop_back();
+			}
 
 			// If job doesn't exist we assume it has already completed.
 			// This is true as long as we're respecting task-graph (anti-)dependencies when processing tasks.
@@ -82,15 +365,40 @@ namespace detail {
 				const auto it = jobs.find(d);
 				if(it != jobs.end()) {
 					it->second.dependants.push_back(pkg.cid);
-					jobs[pkg.cid].unsatisfied_dependencies++;
+					handle.unsatisfied_dependencies++;
 				}
 			}
+
+			if(handle.unsatisfied_dependencies == 0) {
+				make_ready(handle);
+			} else {
+				blocked_jobs.push_back(handle);
+			}
 		}
 
+		void make_ready(job_handle& handle) { (handle.cmd == command::PUSH ? ready_pushes : ready_jobs).push_back(handle); }
+		bool start_ready_jobs(job_list& ready);
+		void complete_job(job_handle& handle);
+
 		void run();
+		bool receive_local_commands(bool& done);
+		bool receive_command_batches(bool& done);
+		void process_command(const command_pkg& pkg, const std::vector<command_id>& dependencies, bool& done);
 		void handle_command(const command_pkg& pkg, const std::vector<command_id>& dependencies);
 
 		void update_metrics();
+
+		/**
+		 * Returns the id below which all commands for this node have completed.
+		 *
+		 * This relies on commands being sent to each node in ascending order of their ids (across flushes), so that no command
+		 * with a smaller id than any received command can still be in flight.
+		 */
+		command_id get_completed_watermark();
+
+		void record_compute_throughput(const worker_job& job);
+		void send_progress_report();
+		void poll_progress_reports();
 	};
 
 } // namespace detail
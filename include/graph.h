@@ -2,6 +2,7 @@
 
 #include <mutex>
 #include <utility>
+#include <vector>
 
 #include <boost/graph/adjacency_list.hpp>
 // As of Boost 1.70, this includes a header which contains a __noinline__ attribute
@@ -48,8 +49,6 @@ namespace detail {
 	// -------------------------------------------------------------------------------------------------------------------
 
 	struct tdag_vertex_properties {
-		std::string label;
-
 		// Whether this task has been processed into the command dag
 		bool processed = false;
 
@@ -90,7 +89,6 @@ namespace detail {
 	using cdag_edge = boost::adjacency_list_traits<cdag_OutEdgeListS, cdag_VertexListS, cdag_DirectedS, cdag_EdgeListS>::edge_descriptor;
 
 	struct cdag_vertex_properties {
-		std::string label;
 		command cmd = command::NOP;
 		command_id cid;
 		node_id nid = 0;
@@ -110,6 +108,9 @@ namespace detail {
 		// Stores the begin/end commands for each task.
 		std::unordered_map<task_id, std::pair<cdag_vertex, cdag_vertex>> task_vertices;
 
+		// Stores the (non-NOP) commands of each task. Once a task has been built, they are in the order in which they are to be flushed.
+		std::unordered_map<task_id, std::vector<cdag_vertex>> task_commands;
+
 		// Stores the corresponding vertex for each command id.
 		std::unordered_map<command_id, cdag_vertex> command_vertices;
 	};
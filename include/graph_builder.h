@@ -15,7 +15,6 @@ namespace detail {
 		node_id nid = 0;
 		task_id tid = 0;
 		command_id cid = 0;
-		std::string label = "";
 		command cmd = command::NOP;
 		command_data data = {nop_data{}};
 	};
@@ -42,7 +41,7 @@ namespace detail {
 	  public:
 		graph_builder(command_dag& command_graph);
 
-		command_id add_command(cdag_vertex a, cdag_vertex b, node_id nid, task_id tid, command cmd, command_data data, std::string label = "");
+		command_id add_command(cdag_vertex a, cdag_vertex b, node_id nid, task_id tid, command cmd, command_data data);
 
 		void add_dependency(command_id dependant, command_id dependency, bool anti = false);
 
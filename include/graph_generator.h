@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -61,19 +62,48 @@ namespace detail {
 		 * @param num_nodes Number of CELERITY nodes, including the master node.
 		 * @param tm
 		 * @param flush_cb Callback invoked for each command that is being flushed
+		 * @param split_transformer Transformer used to split compute commands across nodes. Defaults to the naive_split_transformer.
+		 * @param max_fused_tasks Maximum number of consecutive compute tasks whose COMPUTE commands can be fused into a single command per node.
+		 *                        A value of 1 disables task fusion.
 		 */
-		graph_generator(size_t num_nodes, task_manager& tm, flush_callback flush_cb);
+		graph_generator(size_t num_nodes, task_manager& tm, flush_callback flush_cb, std::shared_ptr<graph_transformer> split_transformer = nullptr,
+		    size_t max_fused_tasks = 1);
 
 		void add_buffer(buffer_id bid, const cl::sycl::range<3>& range);
 
 		void register_transformer(std::shared_ptr<graph_transformer> gt);
 
+		/**
+		 * @brief Sets a callback that is invoked once all commands of a flush have been passed to the flush callback.
+		 *
+		 * This can be used to send the commands resulting from a single flush together, instead of one by one.
+		 */
+		void set_flush_complete_callback(std::function<void()> cb) { flush_complete_cb = std::move(cb); }
+
 		// Build the commands for a single task
 		void build_task(task_id tid);
 
 		boost::optional<task_id> get_unbuilt_task() const;
 
-		void flush(task_id tid) const;
+		/**
+		 * @brief Flushes the commands of task @p tid.
+		 *
+		 * If task fusion is enabled, the commands of compute tasks may be held back, so subsequent tasks can still be fused into them.
+		 * Use ::flush_held_back() to flush them once no more tasks are available.
+		 */
+		void flush(task_id tid);
+
+		/**
+		 * @brief Flushes any commands that have been held back for task fusion.
+		 */
+		void flush_held_back();
+
+		/**
+		 * @brief Informs the graph generator that all commands on node @p nid with an id below @p watermark have completed.
+		 *
+		 * Dependencies onto these commands are omitted when flushing subsequent commands. Can be called from any thread.
+		 */
+		void set_completed_watermark(node_id nid, command_id watermark);
 
 		void print_graph(logger& graph_logger);
 
@@ -82,6 +112,10 @@ namespace detail {
 		const size_t num_nodes;
 		command_dag command_graph;
 		flush_callback flush_cb;
+		std::function<void()> flush_complete_cb;
+
+		// For each node, all commands with ids below this are known to have completed
+		std::unique_ptr<std::atomic<size_t>[]> completed_watermarks;
 
 		// NOTE: We have several data structures that keep track of the "global state" of the distributed program, across all tasks and nodes.
 		// While it might seem that this is problematic when the ordering of tasks can be chosen freely (by the scheduler),
@@ -104,12 +138,42 @@ namespace detail {
 
 		std::vector<std::shared_ptr<graph_transformer>> transformers;
 
+		// Task fusion: Chains of consecutive compute tasks that have the same split and don't require any data transfers between them
+		// are executed as a single COMPUTE command per node. The first task of the chain (the "head") is held back until the chain is complete.
+		const size_t max_fused_tasks;
+		boost::optional<task_id> held_back_task;
+		task_id fusion_chain_tail = 0;
+		// Maps each fused COMPUTE command to the COMPUTE command of the chain head that executes it.
+		std::unordered_map<command_id, command_id> fused_commands;
+		// For each COMPUTE command of a chain head, the fused COMPUTE commands of all subsequent tasks within the chain.
+		std::unordered_map<command_id, std::vector<command_id>> fusion_chains;
+
 		// This mutex mainly serves to protect per-buffer data structures, as new buffers might be added at any time.
 		std::mutex buffer_mutex;
 
 		void generate_anti_dependencies(task_id tid, buffer_id bid, const region_map<boost::optional<command_id>>& last_writers_map,
 		    const GridRegion<3>& write_req, command_id write_cid, graph_builder& gb);
 		void process_task_data_requirements(task_id tid);
+
+		/**
+		 * Fuses the COMPUTE commands of task @p tid into those of the currently held back chain, if they have identical splits
+		 * and only depend on each other (or on commands of previous tasks). Returns whether the task has been fused.
+		 */
+		bool try_fuse_task(task_id tid);
+
+		/**
+		 * Brings the commands of task @p tid into the order in which they are flushed. This has to be called once all of the task's
+		 * commands and dependencies have been generated.
+		 */
+		void order_task_commands(task_id tid);
+
+		/**
+		 * Removes all dependencies that are implied by another dependency within the same task. Paths through commands below
+		 * @p completed_watermark are not considered.
+		 */
+		void remove_transitive_dependencies(std::vector<cdag_vertex>& dependencies, command_id completed_watermark) const;
+
+		void flush_commands(task_id tid) const;
 	};
 
 } // namespace detail
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <stdexcept>
+#include <unordered_set>
+#include <vector>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/graph/breadth_first_search.hpp>
@@ -15,6 +18,9 @@
 
 namespace celerity {
 namespace detail {
+
+	class task;
+
 	namespace graph_utils {
 
 		template <typename Graph>
@@ -65,6 +71,34 @@ namespace detail {
 			return true;
 		}
 
+		/**
+		 * Finds all of @p vertices that are predecessors (direct or indirect) of another one of them.
+		 *
+		 * Paths are only followed through vertices for which @p traverse returns true. All vertices are searched at once, so each vertex
+		 * is visited at most once, regardless of how many of @p vertices it is reachable from.
+		 */
+		template <typename Graph, typename Predicate>
+		std::unordered_set<VertexType<Graph>> find_implied_vertices(
+		    const Graph& graph, const std::vector<VertexType<Graph>>& vertices, const Predicate& traverse) {
+			const std::unordered_set<VertexType<Graph>> candidates(vertices.cbegin(), vertices.cend());
+			std::unordered_set<VertexType<Graph>> implied;
+			// The search starts from all candidates, so there is no need to search from any of them again
+			std::unordered_set<VertexType<Graph>> visited = candidates;
+			std::vector<VertexType<Graph>> stack(candidates.cbegin(), candidates.cend());
+			while(!stack.empty()) {
+				const auto v = stack.back();
+				stack.pop_back();
+				for_predecessors(graph, v, [&](VertexType<Graph> p, typename boost::graph_traits<Graph>::edge_descriptor) {
+					if(candidates.count(p) != 0) { implied.insert(p); }
+					if(visited.count(p) == 0 && traverse(p)) {
+						visited.insert(p);
+						stack.push_back(p);
+					}
+				});
+			}
+			return implied;
+		}
+
 		// Note that we don't check whether the edge u->v actually existed
 		template <typename Graph>
 		VertexType<Graph> insert_vertex_on_edge(VertexType<Graph> u, VertexType<Graph> v, Graph& graph) {
@@ -130,8 +164,19 @@ namespace detail {
 			graph_logger.info(logger_map({{"name", name}, {"data", str}}));
 		}
 
-		void print_graph(const task_dag& tdag, logger& graph_logger);
-		void print_graph(command_dag& cdag, logger& graph_logger);
+		/**
+		 * Returns a label describing the task @p tid, for use in graph printing. @p tsk may be nullptr (e.g. for the INIT task).
+		 */
+		std::string get_task_label(task_id tid, const task* tsk);
+
+		/**
+		 * Returns a label describing a command based on its type and data, for use in graph printing.
+		 */
+		std::string get_command_label(const cdag_vertex_properties& props);
+
+		// Labels are only generated when printing, as they are relatively expensive to build and hardly ever needed.
+		void print_graph(const task_dag& tdag, const std::function<std::string(task_id)>& get_label, logger& graph_logger);
+		void print_graph(command_dag& cdag, const std::function<std::string(cdag_vertex)>& get_label, logger& graph_logger);
 
 	} // namespace graph_utils
 } // namespace detail
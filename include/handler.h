@@ -107,6 +107,18 @@ class handler {
 		}
 	}
 
+	/**
+	 * @brief Hints that this kernel should only be split into chunks whose range is a multiple of @p granularity, e.g. its work-group size.
+	 *
+	 * Note that currently chunks are only split along the first dimension. If the global size is not a multiple of the granularity,
+	 * the last chunk receives the remainder.
+	 */
+	template <int Dims>
+	void set_split_granularity(cl::sycl::range<Dims> granularity) {
+		assert(task_type == detail::task_type::COMPUTE);
+		if(is_prepass()) { set_compute_task_split_granularity(detail::range_cast<3>(granularity)); }
+	}
+
 	template <typename MAF>
 	void run(MAF maf) const {
 		assert(task_type == detail::task_type::MASTER_ACCESS);
@@ -124,6 +136,8 @@ class handler {
 	virtual void set_compute_task_data(
 	    int dimensions, const cl::sycl::range<3>& global_size, const cl::sycl::id<3>& global_offset, const std::string& debug_name) = 0;
 
+	virtual void set_compute_task_split_granularity(const cl::sycl::range<3>& granularity) = 0;
+
 	virtual detail::compute_task_exec_context get_compute_task_exec_context() const = 0;
 
   private:
@@ -180,6 +194,11 @@ namespace detail {
 			task->set_debug_name(debug_name);
 		}
 
+		void set_compute_task_split_granularity(const cl::sycl::range<3>& granularity) override {
+			assert(IsPrepass);
+			task->set_split_granularity(granularity);
+		}
+
 		compute_task_exec_context get_compute_task_exec_context() const override {
 			assert(!IsPrepass);
 			return {sycl_handler, sr, forced_work_group_size};
@@ -219,6 +238,10 @@ namespace detail {
 			throw std::runtime_error("Illegal usage of master access handler");
 		}
 
+		void set_compute_task_split_granularity(const cl::sycl::range<3>& granularity) override {
+			throw std::runtime_error("Illegal usage of master access handler");
+		}
+
 		compute_task_exec_context get_compute_task_exec_context() const override { throw std::runtime_error("Illegal usage of master access handler"); }
 
 	  private:
@@ -81,6 +81,11 @@ namespace detail {
 
 		log_level get_level() const { return static_cast<log_level>(spd_logger->level()); }
 
+		/**
+		 * @brief Returns whether messages of the given level are emitted. Use this to avoid building expensive log messages that would be dropped anyway.
+		 */
+		bool should_log(log_level level) const { return spd_logger->should_log(static_cast<spdlog::level::level_enum>(level)); }
+
 		template <typename Arg1, typename... Args>
 		void trace(const char* fmt, const Arg1& arg1, const Args&... args) {
 			log(spd::level::trace, fmt, arg1, args...);
@@ -1,56 +1,108 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
 #include <utility>
 #include <vector>
 
 #include <mpi.h>
 
+#include "types.h"
+
 namespace celerity {
 namespace detail {
 	namespace mpi_support {
 
 		constexpr int TAG_CMD = 0;
-		constexpr int TAG_DATA_TRANSFER = 1;
-		constexpr int TAG_TELEMETRY = 2;
+		constexpr int TAG_TELEMETRY = 1;
+		// Used for messages containing the data of multiple small PUSHes, see buffer_transfer_manager
+		constexpr int TAG_DATA_AGGREGATE = 2;
+		// Used for notifying other processes on the same host that their shared memory can be reused, see shared_memory_transport
+		constexpr int TAG_SHM_RELEASE = 3;
+		// Data transfers use all tags starting from this one, see get_data_transfer_tag()
+		constexpr int TAG_DATA_TRANSFER_BASE = 4;
+
+		/**
+		 * Returns the tag used for sending the data of PUSH command @p push_cid. This allows receives to be posted for a specific transfer.
+		 *
+		 * Command ids beyond the range of available tags wrap around, so multiple transfers from the same node may share a tag. Receivers must
+		 * therefore not rely on the tag alone, see buffer_transfer_manager::prepare_await_push().
+		 */
+		inline int get_data_transfer_tag(command_id push_cid) {
+			static const int max_tag = [] {
+				int* value;
+				int flag;
+				MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_TAG_UB, &value, &flag);
+				// The standard guarantees at least 32767
+				return flag != 0 ? *value : 32767;
+			}();
+			return TAG_DATA_TRANSFER_BASE + static_cast<int>(static_cast<size_t>(push_cid) % static_cast<size_t>(max_tag - TAG_DATA_TRANSFER_BASE + 1));
+		}
 
-		class single_use_data_type {
+		/**
+		 * A set of pending MPI requests, each associated with a value. The requests are stored contiguously, so all of them can be tested
+		 * with a single call to MPI_Testsome, instead of calling MPI_Test for each one.
+		 */
+		template <typename T>
+		class request_set {
 		  public:
-			single_use_data_type() = default;
-			single_use_data_type(MPI_Datatype dt) : dt(dt){};
-
-			single_use_data_type(single_use_data_type&& other) noexcept { *this = std::move(other); }
-			single_use_data_type& operator=(single_use_data_type&& other) noexcept {
-				if(this != &other) {
-					dt = other.dt;
-					other.dt = MPI_DATATYPE_NULL;
-				}
-				return *this;
+			/**
+			 * @brief Adds @p value, returning the request to be started for it.
+			 *
+			 * The returned pointer (and the reference returned by ::back()) is only valid until the set is modified again.
+			 */
+			MPI_Request* add(T value) {
+				values.push_back(std::move(value));
+				requests.push_back(MPI_REQUEST_NULL);
+				return &requests.back();
 			}
 
-			single_use_data_type(const single_use_data_type& other) = delete;
-			single_use_data_type& operator=(const single_use_data_type& other) = delete;
+			T& back() { return values.back(); }
 
-			MPI_Datatype operator*() const { return dt; }
+			/**
+			 * @brief Removes all values whose request has completed, passing them to @p on_complete first.
+			 *
+			 * @p on_complete must not modify the set.
+			 *
+			 * @returns Whether any request has completed.
+			 */
+			template <typename Callback>
+			bool test_some(Callback&& on_complete) {
+				if(requests.empty()) return false;
+				indices.resize(requests.size());
+				int count;
+				MPI_Testsome(static_cast<int>(requests.size()), requests.data(), &count, indices.data(), MPI_STATUSES_IGNORE);
+				if(count == MPI_UNDEFINED || count == 0) return false;
 
-			~single_use_data_type() {
-				if(dt != MPI_DATATYPE_NULL) { MPI_Type_free(&dt); }
+				// Remove back to front, so moving the last element into a gap never affects one that is yet to be removed
+				std::sort(indices.begin(), indices.begin() + count, std::greater<int>());
+				for(int i = 0; i < count; ++i) {
+					const auto idx = static_cast<size_t>(indices[i]);
+					on_complete(values[idx]);
+					if(idx != values.size() - 1) {
+						values[idx] = std::move(values.back());
+						requests[idx] = requests.back();
+					}
+					values.pop_back();
+					requests.pop_back();
+				}
+				return true;
+			}
+
+			size_t size() const { return values.size(); }
+			bool empty() const { return values.empty(); }
+
+			void clear() {
+				values.clear();
+				requests.clear();
 			}
 
 		  private:
-			MPI_Datatype dt = MPI_DATATYPE_NULL;
+			std::vector<MPI_Request> requests;
+			std::vector<T> values;
+			std::vector<int> indices;
 		};
 
-		/**
-		 * @brief Constructs a new MPI data type for a particular list of blocks.
-		 *
-		 * The returned data type uses MPI_BYTE internally, with block displacements set to the given pointers, i.e. using the type
-		 * operates directly on the objects pointed to. This is useful e.g. when transferring multiple objects that don't exist in a contiguous memory region.
-		 *
-		 * @param blocks A list pairs of an object size (in bytes) and a pointer to the object
-		 * @returns A RAII-wrapped MPI data type
-		 */
-		single_use_data_type build_single_use_composite_type(const std::vector<std::pair<size_t, void*>>& blocks);
-
 	} // namespace mpi_support
 } // namespace detail
 } // namespace celerity
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+#include <mpi.h>
+
+#include "types.h"
+
+namespace celerity {
+namespace detail {
+
+	/**
+	 * Transfers buffer data using one-sided MPI operations, instead of matching sends and receives.
+	 *
+	 * Each node exposes an MPI window containing one receive ring per source node. Senders manage their ring in each target's window
+	 * themselves: They MPI_Put a message into the next free entry, followed by setting the entry's ready flag. Receivers poll the flags of
+	 * all their rings, hand each message to a callback and return the consumed space to the sender by writing into its window in turn.
+	 * This way no messages need to be matched, and data never ends up in MPI's unexpected-message queue.
+	 *
+	 * Constructing and destroying the transport is collective over all processes in MPI_COMM_WORLD.
+	 */
+	class rma_transport {
+	  public:
+		/**
+		 * @param region_size The size of the receive ring for each source node, in bytes. Has to be the same on all nodes.
+		 */
+		explicit rma_transport(size_t region_size);
+		~rma_transport();
+
+		rma_transport(const rma_transport&) = delete;
+		rma_transport& operator=(const rma_transport&) = delete;
+
+		/**
+		 * Returns whether a message of @p message_size bytes can be transferred at all, i.e. whether it fits into a ring.
+		 */
+		bool can_transfer(size_t message_size) const { return get_entry_size(message_size) <= region_size; }
+
+		/**
+		 * Space reserved for a single message in the ring of a target node.
+		 */
+		struct entry {
+			node_id target;
+			size_t message_size;
+			// Displacements of the entry itself, the space skipped at the end of the ring in front of it (if any) and the following entry
+			MPI_Aint displacement = -1;
+			MPI_Aint skipped_displacement = -1;
+			MPI_Aint next_displacement = -1;
+
+			bool is_valid() const { return displacement >= 0; }
+		};
+
+		/**
+		 * @brief Reserves space for a message of @p message_size bytes in the ring of node @p target.
+		 *
+		 * @returns The entry to pass to ::put() and ::publish(), which is invalid if the ring is currently too full.
+		 */
+		entry allocate(node_id target, size_t message_size);
+
+		/**
+		 * @brief Starts writing @p message into the previously allocated entry @p e.
+		 *
+		 * @p message has to remain valid until @p request has completed.
+		 */
+		void put(const entry& e, const void* message, MPI_Request* request);
+
+		/**
+		 * @brief Marks entry @p e as written. Must only be called once the request returned by ::put() has completed.
+		 *
+		 * The entry is made visible to the target by the next call to ::poll(), together with all other entries written in the meantime.
+		 * The receiver reads its ring in order, so entries are published in the order they were allocated: If an older entry for the same
+		 * target is still being written, @p e is only published along with it.
+		 */
+		void publish(const entry& e);
+
+		/**
+		 * @brief Publishes all entries marked through ::publish(), then passes all messages that have been published to this node to
+		 * @p consume, in the order they were published per source.
+		 *
+		 * The message is only valid for the duration of the call. Updates to other nodes' windows are batched, so that each of them is
+		 * flushed at most twice per call. This blocks until published messages have arrived at their target, which usually is the case already.
+		 *
+		 * @returns Whether any message has been consumed or published.
+		 */
+		bool poll(const std::function<void(const char* message)>& consume);
+
+	  private:
+		// Each entry starts with its state and the size of the message, followed by the message itself. Entries are aligned to cache lines.
+		static constexpr size_t entry_header_size = 2 * sizeof(uint64_t);
+		static_assert(entry_header_size % alignof(std::max_align_t) == 0, "Messages must be suitably aligned");
+		static constexpr size_t alignment = 64;
+
+		MPI_Win window = MPI_WIN_NULL;
+		char* window_base = nullptr;
+		node_id local_nid;
+		size_t num_nodes;
+		size_t region_size;
+
+		// Total number of bytes written into each target's ring, including skipped space at its end. Only ever increases.
+		// The target reports how many of those it has consumed into our window in turn.
+		std::vector<uint64_t> produced_bytes;
+		// Total number of bytes consumed from each source's ring. Also used as the origin buffer when reporting it to the source.
+		std::vector<uint64_t> consumed_bytes;
+
+		struct unpublished_entry {
+			entry e;
+			bool written;
+		};
+		// Allocated entries that haven't been published yet, in allocation order, by target
+		std::vector<std::deque<unpublished_entry>> unpublished;
+		// How many entries at the front of each target's queue are published by the current ::publish_written_entries()
+		std::vector<size_t> publish_counts;
+		// Origin buffers for the entry headers written by the current ::publish_written_entries(), which have to remain valid until they are flushed
+		std::vector<uint64_t> header_buffers;
+		// Targets whose window has been written to since the last flush
+		std::vector<node_id> flush_targets;
+
+		static size_t get_entry_size(size_t message_size) { return (entry_header_size + message_size + alignment - 1) / alignment * alignment; }
+
+		// The window starts with one counter per source node, which is where that node reports how much of our ring it has consumed
+		MPI_Aint get_region_displacement(node_id source) const { return static_cast<MPI_Aint>(num_nodes * sizeof(uint64_t) + source * region_size); }
+
+		uint64_t get_reported_consumed_bytes(node_id target) const;
+
+		/**
+		 * Publishes all entries at the front of each target's queue that have been written. Returns whether there were any.
+		 */
+		bool publish_written_entries();
+	};
+
+} // namespace detail
+} // namespace celerity
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -9,10 +8,11 @@
 #include <mpi.h>
 
 #include "buffer_storage.h"
+#include "command_batch.h"
 #include "config.h"
 #include "device_queue.h"
 #include "logger.h"
-#include "mpi_support.h"
+#include "transport.h"
 #include "types.h"
 
 namespace celerity {
@@ -73,18 +73,26 @@ namespace detail {
 			return buffer_ptrs.count(bid) == 1;
 		}
 
-		std::shared_ptr<raw_data_read_handle> get_buffer_data(buffer_id bid, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range) const {
-			std::lock_guard<std::mutex> lock(buffer_mutex);
-			assert(buffer_ptrs.count(bid) == 1);
-			return buffer_ptrs.at(bid)->get_data(queue->get_sycl_queue(), offset, range);
+		size_t get_buffer_element_size(buffer_id bid) const { return get_buffer_storage(bid)->get_element_size(); }
+
+		/**
+		 * @brief Copies the given buffer range to the host. Can be called from any thread.
+		 */
+		std::shared_ptr<raw_data_read_handle> get_buffer_data(
+		    buffer_id bid, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range, size_t prefix_size = 0) const {
+			// Don't hold the lock while waiting for the copy, so other threads can access buffers in the meantime
+			return get_buffer_storage(bid)->get_data(queue->get_sycl_queue(), offset, range, prefix_size);
 		}
 
-		void set_buffer_data(buffer_id bid, const raw_data_handle& dh) {
-			std::lock_guard<std::mutex> lock(buffer_mutex);
-			assert(buffer_ptrs.count(bid) == 1);
-			buffer_ptrs[bid]->set_data(queue->get_sycl_queue(), dh);
+		/**
+		 * @brief Copies the given buffer range to @p dst, which has to be large enough to hold it. Can be called from any thread.
+		 */
+		void get_buffer_data_into(buffer_id bid, const cl::sycl::id<3>& offset, const cl::sycl::range<3>& range, void* dst) const {
+			get_buffer_storage(bid)->get_data_into(queue->get_sycl_queue(), offset, range, dst);
 		}
 
+		void set_buffer_data(buffer_id bid, const raw_data_handle& dh) { get_buffer_storage(bid)->set_data(queue->get_sycl_queue(), dh); }
+
 		std::shared_ptr<logger> get_logger() const { return default_logger; }
 
 		/**
@@ -126,13 +134,10 @@ namespace detail {
 		// TODO: What is a good size for this?
 		ctpl::thread_pool thread_pool{3};
 
-		struct flush_handle {
-			command_pkg pkg;
-			std::vector<command_id> dependencies;
-			MPI_Request req;
-			mpi_support::single_use_data_type data_type;
-		};
-		std::deque<flush_handle> active_flushes;
+		// Commands are collected per target node during a flush, and then sent as a single message
+		std::vector<command_batch> pending_batches;
+		// Used by the scheduler thread for sending command batches
+		std::unique_ptr<transport> cmd_transport;
 
 		runtime(int* argc, char** argv[], cl::sycl::device* user_device = nullptr);
 		runtime(const runtime&) = delete;
@@ -143,8 +148,21 @@ namespace detail {
 		 */
 		void maybe_destroy_runtime() const;
 
+		std::shared_ptr<buffer_storage_base> get_buffer_storage(buffer_id bid) const {
+			std::lock_guard<std::mutex> lock(buffer_mutex);
+			assert(buffer_ptrs.count(bid) == 1);
+			return buffer_ptrs.at(bid);
+		}
+
 		void flush_command(node_id target, const command_pkg& pkg, const std::vector<command_id>& dependencies);
 
+		/**
+		 * @brief Sends all commands that have been flushed since the last call, one message per target node.
+		 *
+		 * Also marks the end of the flush for the local executor, whose commands have been passed to it one by one.
+		 */
+		void send_pending_batches();
+
 #ifdef CELERITY_TEST
 		// ------------------------------------------ TESTING UTILS ------------------------------------------
 		// We have to jump through some hoops to be able to re-initialize the runtime for unit testing.
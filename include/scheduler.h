@@ -1,7 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -13,8 +15,18 @@ namespace detail {
 
 	class scheduler {
 	  public:
+		using utilization_callback = std::function<void(double)>;
+
 		scheduler(std::shared_ptr<graph_generator> ggen);
 
+		/**
+		 * @brief Sets a callback that is periodically invoked (on the scheduler thread) with the fraction of time in [0, 1] spent building
+		 * and flushing tasks, as opposed to waiting for new tasks.
+		 *
+		 * Has to be called before ::startup().
+		 */
+		void set_utilization_callback(utilization_callback cb) { utilization_cb = std::move(cb); }
+
 		void startup();
 
 		void shutdown();
@@ -33,6 +45,10 @@ namespace detail {
 		std::condition_variable tasks_available_cv;
 		std::thread schd_thrd;
 
+		// Busy time is reported once per window (and only if a task has been scheduled within that window)
+		static constexpr std::chrono::milliseconds utilization_window{100};
+		utilization_callback utilization_cb;
+
 		/**
 		 * This is called by the worker thread.
 		 */
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+#include <mpi.h>
+
+#include "mpi_support.h"
+#include "types.h"
+
+namespace celerity {
+namespace detail {
+
+	/**
+	 * Transfers buffer data between nodes running on the same host through shared memory, instead of sending it through MPI.
+	 *
+	 * Each process owns a segment of an MPI shared memory window that all processes on the same host can access directly.
+	 * The sender writes a payload into its own segment once and notifies the receiver (which is up to the caller), who then reads
+	 * it from there once and calls ::release_peer_payload(), so the sender can reuse that part of its segment.
+	 *
+	 * Constructing and destroying the transport is collective over all processes in MPI_COMM_WORLD.
+	 */
+	class shared_memory_transport {
+	  public:
+		/**
+		 * @param segment_size The size of this process' segment, in bytes. Other processes on the same host may use different sizes.
+		 */
+		explicit shared_memory_transport(size_t segment_size);
+		~shared_memory_transport();
+
+		shared_memory_transport(const shared_memory_transport&) = delete;
+		shared_memory_transport& operator=(const shared_memory_transport&) = delete;
+
+		/**
+		 * Returns whether a payload of @p size bytes sent from node @p source to node @p target goes through shared memory.
+		 * This can be evaluated by both sides and only depends on whether the two nodes share a host and the size of the source's segment.
+		 */
+		bool is_shared_memory_transfer(node_id source, node_id target, size_t size) const;
+
+		/**
+		 * @brief Reserves @p size bytes in this process' segment.
+		 *
+		 * @returns The offset of the reserved memory, or ::no_space if the segment is currently too full.
+		 */
+		size_t allocate(size_t size);
+
+		char* get_local_ptr(size_t offset) const { return local_segment + offset; }
+		const char* get_peer_ptr(node_id nid, size_t offset) const { return peers.at(nid).segment + offset; }
+
+		/**
+		 * @brief Makes all preceding writes to shared memory visible to the other processes, and vice versa.
+		 *
+		 * This has to be called by the sender after writing a payload and before notifying the receiver, as well as by the receiver
+		 * after having been notified, before reading the payload.
+		 */
+		void sync();
+
+		/**
+		 * @brief Notifies node @p nid that the payload at @p offset in its segment has been read and the memory can be reused.
+		 */
+		void release_peer_payload(node_id nid, size_t offset);
+
+		/**
+		 * @brief Processes release notifications from other processes and completes outgoing ones.
+		 *
+		 * @returns Whether any progress has been made.
+		 */
+		bool poll();
+
+		static constexpr size_t no_space = static_cast<size_t>(-1);
+
+	  private:
+		// Allocations are aligned to cache lines, so payloads don't share lines with each other
+		static constexpr size_t alignment = 64;
+
+		struct peer {
+			char* segment;
+			size_t segment_size;
+		};
+
+		struct allocation {
+			size_t offset;
+			size_t size;
+			bool released;
+		};
+
+		MPI_Comm host_comm = MPI_COMM_NULL;
+		MPI_Win window = MPI_WIN_NULL;
+		node_id local_nid;
+		char* local_segment = nullptr;
+		size_t segment_size = 0;
+		// All nodes on the same host, including the local one
+		std::unordered_map<node_id, peer> peers;
+
+		// The segment is used as a ring buffer. Allocations are kept in order, with their memory only being reclaimed once all
+		// older ones have been released as well.
+		std::deque<allocation> allocations;
+		size_t head = 0;
+
+		// The offsets being sent, which have to stay in place until the send has completed
+		mpi_support::request_set<std::unique_ptr<size_t>> outgoing_releases;
+
+		static size_t get_aligned_size(size_t size) { return (size + alignment - 1) / alignment * alignment; }
+
+		void release(size_t offset);
+	};
+
+} // namespace detail
+} // namespace celerity
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <vector>
+
+namespace celerity {
+namespace detail {
+
+	/**
+	 * A bounded, lock-free queue for exactly one producer and one consumer thread.
+	 *
+	 * Elements are moved into and out of a ring buffer of pre-constructed slots. The queue may be used by different producer
+	 * (or consumer) threads over its lifetime, as long as those are properly synchronized with each other (e.g. by joining).
+	 */
+	template <typename T>
+	class spsc_queue {
+	  public:
+		/**
+		 * @param capacity The maximum number of elements in the queue. Is rounded up to the next power of two.
+		 */
+		explicit spsc_queue(size_t capacity) : slots(round_up_to_power_of_two(capacity)), mask(slots.size() - 1) {}
+
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator=(const spsc_queue&) = delete;
+
+		/**
+		 * @brief Moves @p value into the queue, unless the queue is full (in which case @p value remains untouched).
+		 *
+		 * May only be called from the producer thread.
+		 */
+		bool try_push(T& value) {
+			const size_t tail = tail_index.load(std::memory_order_relaxed);
+			if(tail - head_index.load(std::memory_order_acquire) == slots.size()) return false;
+			slots[tail & mask] = std::move(value);
+			tail_index.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * @brief Moves the oldest element of the queue into @p value, if there is any.
+		 *
+		 * May only be called from the consumer thread.
+		 */
+		bool try_pop(T& value) {
+			const size_t head = head_index.load(std::memory_order_relaxed);
+			if(head == tail_index.load(std::memory_order_acquire)) return false;
+			value = std::move(slots[head & mask]);
+			head_index.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t get_capacity() const { return slots.size(); }
+
+	  private:
+		static constexpr size_t cache_line_size = 64;
+
+		std::vector<T> slots;
+		const size_t mask;
+
+		// Producer and consumer indices live on separate cache lines to avoid false sharing
+		char padding0[cache_line_size];
+		std::atomic<size_t> head_index{0};
+		char padding1[cache_line_size - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> tail_index{0};
+		char padding2[cache_line_size - sizeof(std::atomic<size_t>)];
+
+		static size_t round_up_to_power_of_two(size_t value) {
+			assert(value > 0);
+			size_t result = 1;
+			while(result < value) {
+				result <<= 1;
+			}
+			return result;
+		}
+	};
+
+} // namespace detail
+} // namespace celerity
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace celerity {
+namespace detail {
+
+	/**
+	 * Process-wide pool of host memory blocks used for staging buffer data, e.g. for data transfers between nodes.
+	 *
+	 * Requested sizes are rounded up to one of a set of size classes (four per power of two, i.e. at most 25% overhead), and freed
+	 * blocks are kept around for reuse by later requests of the same size class. This way we avoid going through the allocator
+	 * (and page faulting on first touch) for every transfer, as the same transfer sizes tend to recur every iteration.
+	 * Can be used from any thread.
+	 */
+	class staging_buffer_pool {
+	  public:
+		static constexpr size_t min_block_size = 4096;
+		// Blocks are only retained as long as the total size of all free blocks doesn't exceed this
+		static constexpr size_t max_retained_bytes = 1024ull * 1024 * 1024;
+
+		static staging_buffer_pool& get_instance();
+
+		~staging_buffer_pool();
+
+		/**
+		 * @brief Returns an uninitialized block of at least @p size bytes, aligned for any fundamental type.
+		 */
+		void* allocate(size_t size);
+
+		/**
+		 * @brief Returns a block to the pool. @p size has to be the size originally passed to ::allocate().
+		 */
+		void free(void* ptr, size_t size);
+
+		/**
+		 * Returns the size class index and actual block size used for allocations of @p size bytes.
+		 */
+		static std::pair<size_t, size_t> get_size_class(size_t size);
+
+		size_t get_retained_bytes() const {
+			std::lock_guard<std::mutex> lock(mutex);
+			return retained_bytes;
+		}
+
+	  private:
+		mutable std::mutex mutex;
+		std::vector<std::vector<void*>> free_blocks;
+		size_t retained_bytes = 0;
+	};
+
+	/**
+	 * Move-only owner of a block obtained from the staging_buffer_pool.
+	 */
+	class staging_buffer {
+	  public:
+		staging_buffer() = default;
+		explicit staging_buffer(size_t size) : ptr(static_cast<char*>(staging_buffer_pool::get_instance().allocate(size))), size(size) {}
+
+		staging_buffer(const staging_buffer&) = delete;
+		staging_buffer& operator=(const staging_buffer&) = delete;
+
+		staging_buffer(staging_buffer&& other) noexcept : ptr(other.ptr), size(other.size) { other.ptr = nullptr; }
+		staging_buffer& operator=(staging_buffer&& other) noexcept {
+			std::swap(ptr, other.ptr);
+			std::swap(size, other.size);
+			return *this;
+		}
+
+		~staging_buffer() {
+			if(ptr != nullptr) { staging_buffer_pool::get_instance().free(ptr, size); }
+		}
+
+		char* get() const { return ptr; }
+		size_t get_size() const { return size; }
+
+	  private:
+		char* ptr = nullptr;
+		size_t size = 0;
+	};
+
+} // namespace detail
+} // namespace celerity
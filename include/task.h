@@ -58,6 +58,7 @@ namespace detail {
 		void set_global_size(cl::sycl::range<3> gs) { global_size = gs; }
 		void set_global_offset(cl::sycl::id<3> offset) { global_offset = offset; }
 		void set_debug_name(std::string name) { debug_name = name; };
+		void set_split_granularity(cl::sycl::range<3> granularity) { split_granularity = granularity; }
 
 		void add_range_mapper(buffer_id bid, std::unique_ptr<range_mapper_base>&& rm) { range_mappers[bid].push_back(std::move(rm)); }
 
@@ -67,6 +68,8 @@ namespace detail {
 		cl::sycl::range<3> get_global_size() const { return global_size; }
 		cl::sycl::id<3> get_global_offset() const { return global_offset; }
 		std::string get_debug_name() const { return debug_name; }
+		// Chunks of this task should only be split at multiples of this size (e.g. the work-group size used by the kernel)
+		cl::sycl::range<3> get_split_granularity() const { return split_granularity; }
 
 		std::vector<buffer_id> get_accessed_buffers() const override;
 		std::unordered_set<cl::sycl::access::mode> get_access_modes(buffer_id bid) const override;
@@ -88,6 +91,7 @@ namespace detail {
 		cl::sycl::range<3> global_size;
 		cl::sycl::id<3> global_offset = {};
 		std::string debug_name;
+		cl::sycl::range<3> split_granularity = {1, 1, 1};
 		std::unordered_map<buffer_id, std::vector<std::unique_ptr<range_mapper_base>>> range_mappers;
 	};
 
@@ -39,7 +39,6 @@ namespace detail {
 				const auto task = create_task<compute_task>(std::make_unique<command_group_storage<CGF>>(cgf));
 				auto cgh = std::make_unique<compute_task_handler<true>>(task);
 				cgf(*cgh);
-				task_graph[task->get_id()].label = fmt::format("{} ({})", task_graph[task->get_id()].label, task->get_debug_name());
 				if(is_master_node) { compute_dependencies(task->get_id()); }
 			}
 			invoke_callbacks();
@@ -56,7 +55,6 @@ namespace detail {
 				if(is_master_node) {
 					auto cgh = std::make_unique<master_access_task_handler<true>>(task);
 					cgf(*cgh);
-					task_graph[task->get_id()].label = fmt::format("{} ({})", task_graph[task->get_id()].label, "master-access");
 					compute_dependencies(task->get_id());
 				}
 			}
@@ -129,7 +127,6 @@ namespace detail {
 			const auto task = std::make_shared<Task>(tid, std::forward<Args...>(args...));
 			task_map[tid] = task;
 			boost::add_vertex(task_graph);
-			task_graph[tid].label = fmt::format("Task {}", static_cast<size_t>(tid));
 			return task;
 		}
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "graph_transformer.h"
+#include "types.h"
+
+namespace celerity {
+namespace detail {
+
+	/**
+	 * Splits compute commands into one chunk per node, sized proportionally to each node's throughput.
+	 *
+	 * Throughput is estimated from COMPUTE job durations reported back by the workers. To avoid oscillation, new measurements
+	 * are blended into an exponentially weighted moving average. Alternatively, the per-node weights can be pinned to fixed values,
+	 * in which case all measurements are ignored.
+	 */
+	class load_balancing_split_transformer : public graph_transformer {
+	  public:
+		static constexpr double default_damping = 0.5;
+
+		/**
+		 * @param num_workers Number of CELERITY nodes, including the master node.
+		 * @param damping The weight (in [0, 1)) of the previous throughput estimate when incorporating a new measurement.
+		 * @param pinned_weights If non-empty, the per-node weights are fixed to these values. Must contain exactly one entry per node.
+		 * @param chunks_per_node Each node's share is further split into this many consecutive, equally sized chunks (see naive_split_transformer).
+		 * @param forced_work_group_size The work-group size forced upon all kernels (CELERITY_FORCE_WG), or 0. Chunk boundaries are aligned to it.
+		 */
+		load_balancing_split_transformer(
+		    size_t num_workers, double damping, std::vector<double> pinned_weights = {}, size_t chunks_per_node = 1, size_t forced_work_group_size = 0);
+
+		void transform_task(const std::shared_ptr<const task>& tsk, scoped_graph_builder& gb) override;
+
+		/**
+		 * @brief Incorporates a new measurement of node @p nid having processed @p work_items kernel items in @p duration.
+		 *
+		 * This is thread-safe, as measurements are typically received on a different thread than the one building tasks.
+		 */
+		void report_throughput(node_id nid, size_t work_items, std::chrono::microseconds duration);
+
+		/**
+		 * @brief Scales the weight of the master node by @p weight in [0, 1], where 0 excludes it from computing (see naive_split_transformer).
+		 *
+		 * Unlike measurements, this also applies to pinned weights. This must only be called from the thread building tasks.
+		 */
+		void set_master_weight(double weight);
+
+		/**
+		 * @brief Returns the normalized weight of each node that will be used for the next split.
+		 */
+		std::vector<double> get_weights() const;
+
+	  private:
+		// No node is assigned less than this fraction of the average node's share, so we keep receiving measurements for it.
+		static constexpr double min_relative_weight = 0.1;
+
+		const size_t num_workers;
+		const size_t chunks_per_node;
+		const size_t forced_work_group_size;
+		const double damping;
+		const bool weights_pinned;
+		double master_weight = 1.0;
+
+		// Estimated throughput (items per microsecond) for each node. Zero means no measurement has been received yet.
+		// If weights are pinned, this instead stores the fixed weights.
+		std::vector<double> throughputs;
+		mutable std::mutex throughputs_mutex;
+	};
+
+} // namespace detail
+} // namespace celerity
@@ -7,12 +7,29 @@ namespace detail {
 
 	class naive_split_transformer : public graph_transformer {
 	  public:
-		explicit naive_split_transformer(size_t num_workers);
+		/**
+		 * @param num_workers Number of CELERITY nodes, including the master node.
+		 * @param chunks_per_node Each node receives this many consecutive chunks, allowing chunks that don't depend on
+		 *                        data transfers to be computed while the transfers for the remaining chunks are in flight.
+		 * @param master_weight The share of work assigned to the master node, relative to all other nodes (see ::set_master_weight()).
+		 * @param forced_work_group_size The work-group size forced upon all kernels (CELERITY_FORCE_WG), or 0. Chunk boundaries are aligned to it.
+		 */
+		explicit naive_split_transformer(size_t num_workers, size_t chunks_per_node = 1, double master_weight = 1.0, size_t forced_work_group_size = 0);
 
 		void transform_task(const std::shared_ptr<const task>& tsk, scoped_graph_builder& gb) override;
 
+		/**
+		 * @brief Sets the weight in [0, 1] of the master node relative to all other nodes, where 0 excludes it from computing.
+		 *
+		 * As the master node also runs the scheduler, it may be beneficial to assign it less work. This must only be called from the thread building tasks.
+		 */
+		void set_master_weight(double weight);
+
 	  private:
 		size_t num_workers;
+		size_t chunks_per_node;
+		size_t forced_work_group_size;
+		double master_weight;
 	};
 
 } // namespace detail
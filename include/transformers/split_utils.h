@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "ranges.h"
+#include "types.h"
+
+namespace celerity {
+namespace detail {
+
+	class compute_task;
+	class scoped_graph_builder;
+
+	/**
+	 * @brief Returns the granularity at which chunks of @p ctsk can be split along the first dimension.
+	 *
+	 * This is the least common multiple of the task's split granularity hint and the forced work-group size (if any).
+	 */
+	size_t get_split_granularity(const compute_task& ctsk, size_t forced_work_group_size);
+
+	/**
+	 * @brief Splits a chunk along its first dimension into @p num_chunks chunks of (roughly) equal size.
+	 *
+	 * All chunk boundaries are multiples of @p granularity (relative to the chunk's offset). Any remaining granules are distributed
+	 * evenly across chunks, only the remainder of the range that doesn't fill an entire granule is assigned to the last chunk.
+	 */
+	std::vector<chunk<3>> split_equal(const chunk<1>& full_chunk, size_t num_chunks, size_t granularity = 1);
+	std::vector<chunk<3>> split_equal(const chunk<2>& full_chunk, size_t num_chunks, size_t granularity = 1);
+	std::vector<chunk<3>> split_equal(const chunk<3>& full_chunk, size_t num_chunks, size_t granularity = 1);
+
+	/**
+	 * @brief Splits a chunk along its first dimension into one chunk per weight, with sizes proportional to the given weights.
+	 *
+	 * Boundaries are rounded to the nearest multiple of @p granularity, so the resulting chunks always add up to the original chunk.
+	 * Note that chunks may be empty if their weight is small compared to the size of the first dimension.
+	 */
+	std::vector<chunk<3>> split_weighted(const chunk<3>& full_chunk, const std::vector<double>& weights, size_t granularity = 1);
+
+	/**
+	 * @brief Splits COMPUTE command @p cid using ::split_weighted(), assigning each node @p chunks_per_node consecutive chunks.
+	 *
+	 * Empty chunks are omitted altogether, so nodes with zero weight don't receive any commands.
+	 */
+	void split_weighted_and_assign(scoped_graph_builder& gb, command_id cid, const chunk<3>& full_chunk, const std::vector<double>& weights,
+	    size_t chunks_per_node, size_t granularity = 1);
+
+} // namespace detail
+} // namespace celerity
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <mpi.h>
+
+#include "mpi_support.h"
+#include "types.h"
+
+namespace celerity {
+namespace detail {
+
+	/**
+	 * Delivers control messages (command batches and progress reports) between nodes.
+	 *
+	 * Messages sent from one node to another on the same channel are received in the order they were sent. Each instance is used
+	 * by a single thread only; a node may create multiple instances (e.g. one for the scheduler and one for the executor), which
+	 * then share the node's incoming messages.
+	 */
+	class transport {
+	  public:
+		enum class channel {
+			COMMANDS,         // Command batches, sent from the master node to all nodes
+			PROGRESS_REPORTS, // Progress reports, sent from all nodes to the master node
+		};
+
+		using sent_callback = std::function<void(node_id target, std::vector<unsigned char> message)>;
+
+		virtual ~transport() = default;
+
+		virtual node_id get_local_nid() const = 0;
+		virtual size_t get_num_nodes() const = 0;
+
+		/**
+		 * @brief Starts sending @p message to node @p target. The transport keeps the message around until the send has completed.
+		 */
+		virtual void send(node_id target, channel ch, std::vector<unsigned char> message) = 0;
+
+		/**
+		 * @brief Hands all messages whose send has completed since the last call back to @p on_sent, so their capacity can be reused.
+		 *
+		 * Transports that take over the message itself (instead of copying it) never return it.
+		 */
+		virtual void poll_sends(const sent_callback& on_sent) = 0;
+
+		/**
+		 * @brief Returns the number of messages sent through this instance that have not completed yet.
+		 */
+		virtual size_t get_pending_send_count() const = 0;
+
+		/**
+		 * @brief Receives the next message on channel @p ch, if there is one.
+		 *
+		 * @param message Receives the message. Its capacity is reused if possible.
+		 * @returns Whether a message has been received.
+		 */
+		virtual bool try_receive(channel ch, node_id& source, std::vector<unsigned char>& message) = 0;
+	};
+
+	/**
+	 * Sends control messages through MPI_COMM_WORLD, with one process per node.
+	 */
+	class mpi_transport final : public transport {
+	  public:
+		mpi_transport();
+
+		node_id get_local_nid() const override { return local_nid; }
+		size_t get_num_nodes() const override { return num_nodes; }
+
+		void send(node_id target, channel ch, std::vector<unsigned char> message) override;
+		void poll_sends(const sent_callback& on_sent) override;
+		size_t get_pending_send_count() const override { return active_sends.size(); }
+		bool try_receive(channel ch, node_id& source, std::vector<unsigned char>& message) override;
+
+	  private:
+		struct send_handle {
+			node_id target;
+			std::vector<unsigned char> message;
+		};
+
+		node_id local_nid;
+		size_t num_nodes;
+		mpi_support::request_set<send_handle> active_sends;
+
+		static int get_tag(channel ch) { return ch == channel::COMMANDS ? mpi_support::TAG_CMD : mpi_support::TAG_TELEMETRY; }
+	};
+
+	/**
+	 * Simulates a number of nodes within a single process, which can be driven by different threads. Sent messages are moved into
+	 * the target's mailbox directly, so sends complete immediately.
+	 *
+	 * This allows testing and benchmarking the exchange of commands between nodes without launching multiple MPI processes.
+	 */
+	class loopback_transport final : public transport {
+	  public:
+		/**
+		 * The mailboxes of all simulated nodes, shared between all their transports.
+		 */
+		class network {
+		  public:
+			explicit network(size_t num_nodes);
+
+			size_t get_num_nodes() const { return num_nodes; }
+
+		  private:
+			friend class loopback_transport;
+
+			struct message {
+				node_id source;
+				std::vector<unsigned char> data;
+			};
+
+			struct mailbox {
+				std::mutex mutex;
+				std::deque<message> messages;
+			};
+
+			size_t num_nodes;
+			// One mailbox per node and channel
+			std::vector<mailbox> mailboxes;
+
+			mailbox& get_mailbox(node_id nid, channel ch) { return mailboxes[nid * 2 + (ch == channel::COMMANDS ? 0 : 1)]; }
+		};
+
+		loopback_transport(std::shared_ptr<network> net, node_id local_nid);
+
+		node_id get_local_nid() const override { return local_nid; }
+		size_t get_num_nodes() const override { return net->get_num_nodes(); }
+
+		void send(node_id target, channel ch, std::vector<unsigned char> message) override;
+		void poll_sends(const sent_callback& on_sent) override {}
+		size_t get_pending_send_count() const override { return 0; }
+		bool try_receive(channel ch, node_id& source, std::vector<unsigned char>& message) override;
+
+	  private:
+		std::shared_ptr<network> net;
+		node_id local_nid;
+	};
+
+} // namespace detail
+} // namespace celerity
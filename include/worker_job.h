@@ -5,6 +5,7 @@
 #include <future> // TODO: Only required for compute job workaround - remove
 #include <limits>
 #include <utility>
+#include <vector>
 
 #include "buffer_transfer_manager.h"
 #include "command.h"
@@ -20,7 +21,11 @@ namespace detail {
 
 	class worker_job {
 	  public:
-		worker_job(command_pkg pkg, std::shared_ptr<logger> job_logger) : pkg(pkg), job_logger(job_logger) {}
+		/**
+		 * @param execution_logger The logger from which the job's own logger context is derived (lazily, see ::get_logger()).
+		 */
+		worker_job(const command_pkg& pkg, std::shared_ptr<logger> execution_logger)
+		    : pkg(pkg), execution_logger(std::move(execution_logger)), tracing(this->execution_logger->should_log(log_level::trace)) {}
 		worker_job(const worker_job&) = delete;
 		worker_job(worker_job&&) = delete;
 
@@ -32,11 +37,36 @@ namespace detail {
 		bool is_running() const { return running; }
 		bool is_done() const { return done; }
 
+		const command_pkg& get_pkg() const { return pkg; }
+
+		/**
+		 * Returns the wall-clock time between starting the job and its completion. Only valid once the job is done.
+		 */
+		std::chrono::microseconds get_execution_time() const {
+			assert(done);
+			return execution_time;
+		}
+
+	  protected:
+		/**
+		 * Jobs only log at trace level, so all logging should be guarded by this, avoiding the cost of building messages otherwise.
+		 */
+		bool is_tracing() const { return tracing; }
+
+		/**
+		 * Returns the logger for this job, with the task and command ids as context. The context is created on first use,
+		 * as doing so for every job is relatively expensive.
+		 */
+		logger& get_logger();
+
 	  private:
 		command_pkg pkg;
+		std::shared_ptr<logger> execution_logger;
 		std::shared_ptr<logger> job_logger;
+		const bool tracing;
 		bool running = false;
 		bool done = false;
+		std::chrono::microseconds execution_time = {};
 
 		// Benchmarking
 		std::chrono::steady_clock::time_point start_time;
@@ -45,7 +75,7 @@ namespace detail {
 		std::chrono::microseconds bench_min = std::numeric_limits<std::chrono::microseconds>::max();
 		std::chrono::microseconds bench_max = std::numeric_limits<std::chrono::microseconds>::min();
 
-		virtual bool execute(const command_pkg& pkg, std::shared_ptr<logger> logger) = 0;
+		virtual bool execute(const command_pkg& pkg) = 0;
 
 		/**
 		 * Returns the job description in the form of the command, as well as a string describing the parameters.
@@ -59,7 +89,8 @@ namespace detail {
 	 */
 	class await_push_job : public worker_job {
 	  public:
-		await_push_job(command_pkg pkg, std::shared_ptr<logger> job_logger, buffer_transfer_manager& btm) : worker_job(pkg, job_logger), btm(btm) {
+		await_push_job(const command_pkg& pkg, std::shared_ptr<logger> execution_logger, buffer_transfer_manager& btm)
+		    : worker_job(pkg, std::move(execution_logger)), btm(btm) {
 			assert(pkg.cmd == command::AWAIT_PUSH);
 		}
 
@@ -67,13 +98,14 @@ namespace detail {
 		buffer_transfer_manager& btm;
 		std::shared_ptr<const buffer_transfer_manager::transfer_handle> data_handle = nullptr;
 
-		bool execute(const command_pkg& pkg, std::shared_ptr<logger> logger) override;
+		bool execute(const command_pkg& pkg) override;
 		std::pair<command, std::string> get_description(const command_pkg& pkg) override;
 	};
 
 	class push_job : public worker_job {
 	  public:
-		push_job(command_pkg pkg, std::shared_ptr<logger> job_logger, buffer_transfer_manager& btm) : worker_job(pkg, job_logger), btm(btm) {
+		push_job(const command_pkg& pkg, std::shared_ptr<logger> execution_logger, buffer_transfer_manager& btm)
+		    : worker_job(pkg, std::move(execution_logger)), btm(btm) {
 			assert(pkg.cmd == command::PUSH);
 		}
 
@@ -81,7 +113,7 @@ namespace detail {
 		buffer_transfer_manager& btm;
 		std::shared_ptr<const buffer_transfer_manager::transfer_handle> data_handle = nullptr;
 
-		bool execute(const command_pkg& pkg, std::shared_ptr<logger> logger) override;
+		bool execute(const command_pkg& pkg) override;
 		std::pair<command, std::string> get_description(const command_pkg& pkg) override;
 	};
 
@@ -91,34 +123,35 @@ namespace detail {
 	 */
 	class compute_job : public worker_job {
 	  public:
-		compute_job(command_pkg pkg, std::shared_ptr<logger> job_logger, detail::device_queue& queue, detail::task_manager& tm)
-		    : worker_job(pkg, job_logger), queue(queue), task_mngr(tm) {
+		compute_job(const command_pkg& pkg, std::shared_ptr<logger> execution_logger, detail::device_queue& queue, detail::task_manager& tm)
+		    : worker_job(pkg, std::move(execution_logger)), queue(queue), task_mngr(tm) {
 			assert(pkg.cmd == command::COMPUTE);
 		}
 
 	  private:
 		detail::device_queue& queue;
 		detail::task_manager& task_mngr;
-		cl::sycl::event event;
+		// One event for each kernel (there are multiple if tasks have been fused into this command)
+		std::vector<cl::sycl::event> events;
 		bool did_log_task_wait = false;
-		bool submitted = false;
 
 		std::future<void> computecpp_workaround_future;
 
-		bool execute(const command_pkg& pkg, std::shared_ptr<logger> logger) override;
+		bool execute(const command_pkg& pkg) override;
 		std::pair<command, std::string> get_description(const command_pkg& pkg) override;
 	};
 
 	class master_access_job : public worker_job {
 	  public:
-		master_access_job(command_pkg pkg, std::shared_ptr<logger> job_logger, detail::task_manager& tm) : worker_job(pkg, job_logger), task_mngr(tm) {
+		master_access_job(const command_pkg& pkg, std::shared_ptr<logger> execution_logger, detail::task_manager& tm)
+		    : worker_job(pkg, std::move(execution_logger)), task_mngr(tm) {
 			assert(pkg.cmd == command::MASTER_ACCESS);
 		}
 
 	  private:
 		detail::task_manager& task_mngr;
 
-		bool execute(const command_pkg& pkg, std::shared_ptr<logger> logger) override;
+		bool execute(const command_pkg& pkg) override;
 		std::pair<command, std::string> get_description(const command_pkg& pkg) override;
 	};
 
@@ -1,6 +1,10 @@
 #include "buffer_transfer_manager.h"
 
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <new>
 
 #include "mpi_support.h"
 #include "runtime.h"
@@ -8,138 +12,408 @@
 namespace celerity {
 namespace detail {
 
+	constexpr size_t buffer_transfer_manager::default_shm_segment_size;
+	constexpr size_t buffer_transfer_manager::rma_region_size;
+	constexpr size_t buffer_transfer_manager::max_aggregated_push_size;
+	constexpr size_t buffer_transfer_manager::max_aggregate_message_size;
+	constexpr size_t buffer_transfer_manager::inline_payload;
+
+	static node_id get_local_nid() {
+		int rank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+		return static_cast<node_id>(rank);
+	}
+
+	buffer_transfer_manager::buffer_transfer_manager(
+	    std::shared_ptr<logger> transfer_logger, size_t shm_segment_size, bool use_rma, size_t async_push_threshold)
+	    : transfer_logger(transfer_logger), async_push_threshold(async_push_threshold), local_nid(get_local_nid()), shm_transport(shm_segment_size) {
+		if(use_rma) { rma = std::make_unique<rma_transport>(rma_region_size); }
+	}
+
+	buffer_transfer_manager::transport buffer_transfer_manager::get_transport(node_id source, node_id target, size_t data_size) const {
+		if(data_size <= max_aggregated_push_size) return transport::AGGREGATED;
+		if(shm_transport.is_shared_memory_transfer(source, target, data_size)) return transport::SHARED_MEMORY;
+		if(rma != nullptr && rma->can_transfer(sizeof(data_header) + data_size)) return transport::RMA;
+		return transport::POINT_TO_POINT;
+	}
+
 	std::shared_ptr<const buffer_transfer_manager::transfer_handle> buffer_transfer_manager::push(const command_pkg& pkg) {
 		assert(pkg.cmd == command::PUSH);
 		auto t_handle = std::make_shared<transfer_handle>();
-		// We are blocking the caller until the buffer has been copied and submitted to MPI
-		// TODO: Investigate doing this in worker thread
-		// --> This probably needs some kind of heuristic, as for small (e.g. ghost cell) transfers the overhead of threading is way too big
 		const push_data& data = pkg.data.push;
-		auto data_handle =
-		    runtime::get_instance().get_buffer_data(data.bid, cl::sycl::range<3>(data.subrange.offset[0], data.subrange.offset[1], data.subrange.offset[2]),
-		        cl::sycl::range<3>(data.subrange.range[0], data.subrange.range[1], data.subrange.range[2]));
+		const auto& sr = data.subrange;
+		const size_t data_size = runtime::get_instance().get_buffer_element_size(data.bid) * sr.range[0] * sr.range[1] * sr.range[2];
+
+		outgoing_bytes += data_size;
+		const auto tp = get_transport(local_nid, data.target, data_size);
+		if(tp == transport::AGGREGATED) {
+			aggregate_push(pkg, data_size, t_handle);
+			return t_handle;
+		}
+
+		auto transfer = std::make_unique<transfer_out>(pkg, data_size, tp);
+		transfer->handle = t_handle;
+		if(tp == transport::SHARED_MEMORY) { transfer->shm_offset = shm_transport.allocate(data_size); }
+		// If there is no space in shared memory right now, staging is retried in ::update_outgoing_transfers()
+		if(tp != transport::SHARED_MEMORY || transfer->shm_offset != shared_memory_transport::no_space) { start_staging(*transfer); }
+		if(!try_send(transfer)) { unsent_transfers.push_back(std::move(transfer)); }
+
+		return t_handle;
+	}
+
+	std::shared_ptr<detail::raw_data_read_handle> buffer_transfer_manager::stage_push_data(const push_data& data, char* shm_payload) {
+		const cl::sycl::id<3> offset(data.subrange.offset[0], data.subrange.offset[1], data.subrange.offset[2]);
+		const cl::sycl::range<3> range(data.subrange.range[0], data.subrange.range[1], data.subrange.range[2]);
+		if(shm_payload != nullptr) {
+			runtime::get_instance().get_buffer_data_into(data.bid, offset, range, shm_payload);
+			return nullptr;
+		}
+		// Reserve space for the header in front of the data, so we can send both as one contiguous message
+		return runtime::get_instance().get_buffer_data(data.bid, offset, range, sizeof(data_header));
+	}
+
+	void buffer_transfer_manager::start_staging(transfer_out& transfer) {
+		char* shm_payload = transfer.tp == transport::SHARED_MEMORY ? shm_transport.get_local_ptr(transfer.shm_offset) : nullptr;
+		if(transfer.size < async_push_threshold) {
+			transfer.data_handle = stage_push_data(transfer.pkg.data.push, shm_payload);
+		} else {
+			// Copying large amounts of data from the device can take a while, so we don't want to block the executor in the meantime
+			const push_data data = transfer.pkg.data.push;
+			transfer.staged_data = runtime::get_instance().execute_async_pooled([data, shm_payload]() { return stage_push_data(data, shm_payload); });
+		}
+	}
+
+	bool buffer_transfer_manager::try_send(std::unique_ptr<transfer_out>& transfer) {
+		auto& t = *transfer;
+		if(t.tp == transport::SHARED_MEMORY && t.shm_offset == shared_memory_transport::no_space) {
+			t.shm_offset = shm_transport.allocate(t.size);
+			if(t.shm_offset == shared_memory_transport::no_space) return false;
+			start_staging(t);
+		}
+		if(t.staged_data.valid()) {
+			if(t.staged_data.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+			t.data_handle = t.staged_data.get();
+		}
+		const push_data& data = t.pkg.data.push;
+		if(t.tp == transport::RMA && !t.rma_entry.is_valid()) {
+			t.rma_entry = rma->allocate(data.target, t.get_message_size());
+			if(!t.rma_entry.is_valid()) return false;
+		}
 
+		assert(t.tp == transport::SHARED_MEMORY || (t.data_handle != nullptr && t.data_handle->linearized_data_size == t.size));
 		// This is a bit of a hack (logging a job event from here), but it's very useful
+		transfer_logger->trace(logger_map{{"job", std::to_string(t.pkg.cid)}, {"event", "Buffer data ready to be sent"}});
+
+		// Make the payload visible to the receiver before notifying it
+		if(t.tp == transport::SHARED_MEMORY) { shm_transport.sync(); }
+		new(t.get_message_ptr()) data_header{data.bid, data.subrange, t.pkg.cid, t.size, t.shm_offset};
+		// The transfer object itself doesn't move, so the message remains valid
+		MPI_Request* request = outgoing_transfers.add(std::move(transfer));
+		if(t.tp == transport::RMA) {
+			rma->put(t.rma_entry, t.get_message_ptr(), request);
+		} else {
+			MPI_Isend(t.get_message_ptr(), static_cast<int>(t.get_message_size()), MPI_BYTE, static_cast<int>(data.target),
+			    mpi_support::get_data_transfer_tag(t.pkg.cid), MPI_COMM_WORLD, request);
+		}
+		return true;
+	}
+
+	void buffer_transfer_manager::aggregate_push(const command_pkg& pkg, size_t data_size, std::shared_ptr<transfer_handle> t_handle) {
+		const push_data& data = pkg.data.push;
+		const size_t part_size = get_aggregate_part_size(data_size);
+		static_assert(get_aggregate_part_size(max_aggregated_push_size) <= max_aggregate_message_size, "Aggregated PUSHes must fit into a message");
+
+		auto& aggregate = pending_aggregates[data.target];
+		if(aggregate != nullptr && aggregate->message_size + part_size > max_aggregate_message_size) { send_aggregate(std::move(aggregate)); }
+		if(aggregate == nullptr) { aggregate = std::make_unique<aggregate_out>(data.target); }
+
 		transfer_logger->trace(logger_map{{"job", std::to_string(pkg.cid)}, {"event", "Buffer data ready to be sent"}});
+		const auto data_handle = runtime::get_instance().get_buffer_data(data.bid,
+		    cl::sycl::range<3>(data.subrange.offset[0], data.subrange.offset[1], data.subrange.offset[2]),
+		    cl::sycl::range<3>(data.subrange.range[0], data.subrange.range[1], data.subrange.range[2]));
+		char* part = aggregate->message.get() + aggregate->message_size;
+		new(part) data_header{data.bid, data.subrange, pkg.cid, data_size, inline_payload};
+		std::memcpy(part + sizeof(data_header), data_handle->linearized_data_ptr, data_size);
 
-		const auto data_size = data_handle->linearized_data_size;
-		auto transfer = std::make_unique<transfer_out>(std::move(data_handle));
-		transfer->handle = t_handle;
-		transfer->header.subrange = data.subrange;
-		transfer->header.bid = data.bid;
-		transfer->header.push_cid = pkg.cid;
-		transfer->data_type = mpi_support::build_single_use_composite_type({{sizeof(data_header), &transfer->header}, {data_size, transfer->get_raw_ptr()}});
+		aggregate->message_size += part_size;
+		aggregate->size += data_size;
+		aggregate->handles.push_back(std::move(t_handle));
+	}
 
-		// Start transmitting data
-		MPI_Isend(MPI_BOTTOM, 1, *transfer->data_type, static_cast<int>(data.target), mpi_support::TAG_DATA_TRANSFER, MPI_COMM_WORLD, &transfer->request);
-		outgoing_transfers.push_back(std::move(transfer));
+	void buffer_transfer_manager::send_aggregated_pushes() {
+		for(auto& p : pending_aggregates) {
+			if(p.second != nullptr) { send_aggregate(std::move(p.second)); }
+		}
+	}
 
-		return t_handle;
+	void buffer_transfer_manager::send_aggregate(std::unique_ptr<aggregate_out> aggregate) {
+		if(transfer_logger->should_log(log_level::trace)) {
+			transfer_logger->trace("Sending {} aggregated pushes ({} bytes) to node {}", aggregate->handles.size(), aggregate->size, aggregate->target);
+		}
+		const auto& a = *aggregate;
+		MPI_Request* request = outgoing_aggregates.add(std::move(aggregate));
+		MPI_Isend(a.message.get(), static_cast<int>(a.message_size), MPI_BYTE, static_cast<int>(a.target), mpi_support::TAG_DATA_AGGREGATE, MPI_COMM_WORLD,
+		    request);
+	}
+
+	void buffer_transfer_manager::prepare_await_push(const command_pkg& pkg) {
+		assert(pkg.cmd == command::AWAIT_PUSH);
+		const await_push_data& data = pkg.data.await_push;
+		// The data might have already been received as part of an aggregated message
+		if(push_blackboard.count(data.source_cid) != 0) return;
+		// In some rare situations the local runtime might not yet know about this buffer. We then post the receive in ::await_push instead.
+		if(!runtime::get_instance().has_buffer(data.bid)) return;
+
+		const auto& sr = data.subrange;
+		const size_t data_size = runtime::get_instance().get_buffer_element_size(data.bid) * sr.range[0] * sr.range[1] * sr.range[2];
+		auto t_handle = std::make_shared<incoming_transfer_handle>();
+		const auto tp = get_transport(data.source, local_nid, data_size);
+		if(tp == transport::AGGREGATED || tp == transport::RMA) {
+			// There is no dedicated message to receive, see ::deliver_unposted_transfer()
+			pending_unposted_transfers[data.source_cid] = t_handle;
+			push_blackboard[data.source_cid] = std::move(t_handle);
+			return;
+		}
+
+		// Command ids wrap around when they are mapped to tags, so another transfer from the same node may still be expecting a message with
+		// this tag. A second receive could then be matched by the wrong message, so we probe for the data instead.
+		const int tag = mpi_support::get_data_transfer_tag(data.source_cid);
+		auto& posted_tags = posted_transfer_tags[data.source];
+		auto& probed_tags = probed_transfers[data.source];
+		if(posted_tags.count(tag) != 0 || probed_tags.count(tag) != 0) {
+			probed_tags[tag].insert(data.source_cid);
+			pending_unposted_transfers[data.source_cid] = t_handle;
+			push_blackboard[data.source_cid] = std::move(t_handle);
+			return;
+		}
+
+		t_handle->transfer = std::make_unique<transfer_in>();
+		auto& transfer = *t_handle->transfer;
+		transfer.source = data.source;
+		transfer.push_cid = data.source_cid;
+		// When the data is transferred through shared memory, only the header is sent
+		const size_t message_size = sizeof(data_header) + (tp == transport::SHARED_MEMORY ? 0 : data_size);
+		transfer.message = staging_buffer(message_size);
+		MPI_Irecv(transfer.message.get(), static_cast<int>(message_size), MPI_BYTE, static_cast<int>(data.source), tag, MPI_COMM_WORLD,
+		    incoming_transfers.add(t_handle));
+		posted_tags.emplace(tag, data.source_cid);
+		push_blackboard[data.source_cid] = std::move(t_handle);
 	}
 
 	std::shared_ptr<const buffer_transfer_manager::transfer_handle> buffer_transfer_manager::await_push(const command_pkg& pkg) {
 		assert(pkg.cmd == command::AWAIT_PUSH);
 		const await_push_data& data = pkg.data.await_push;
 
-		std::shared_ptr<incoming_transfer_handle> t_handle;
+		if(push_blackboard.count(data.source_cid) == 0) {
+			// The receive couldn't be posted ahead of time, as the buffer wasn't known yet. Busy wait until it is.
+			while(!runtime::get_instance().has_buffer(data.bid)) {}
+			prepare_await_push(pkg);
+		}
+		const auto t_handle = push_blackboard.at(data.source_cid);
+		push_blackboard.erase(data.source_cid);
+		t_handle->requested = true;
+
 		// Check to see if we have (fully) received the push already
-		if(push_blackboard.count(data.source_cid) != 0) {
-			t_handle = push_blackboard[data.source_cid];
-			push_blackboard.erase(data.source_cid);
-			assert(t_handle->transfer != nullptr);
-			assert(t_handle->transfer->header.bid == data.bid);
-			assert(t_handle->transfer->header.subrange == data.subrange);
-			assert(t_handle->complete);
-			write_data_to_buffer(*t_handle->transfer);
-		} else {
-			t_handle = std::make_shared<incoming_transfer_handle>();
-			// Store new handle so we can mark it as complete when the push is received
-			push_blackboard[data.source_cid] = t_handle;
+		if(t_handle->received) {
+			write_data_to_buffer(t_handle->transfer->header, t_handle->transfer->get_payload());
+			t_handle->transfer = nullptr;
+			t_handle->complete = true;
 		}
 
 		return t_handle;
 	}
 
-	void buffer_transfer_manager::poll() {
-		poll_incoming_transfers();
-		update_incoming_transfers();
-		update_outgoing_transfers();
+	bool buffer_transfer_manager::poll() {
+		// Normally this has already been done by the executor right after starting the PUSH jobs
+		send_aggregated_pushes();
+		bool progress = update_incoming_transfers();
+		progress = receive_probed_transfers() || progress;
+		progress = receive_aggregated_transfers() || progress;
+		progress = shm_transport.poll() || progress;
+		progress = update_outgoing_transfers() || progress;
+		// One-sided transfers that have just been written are published right away, so they are visible by the time the executor sees the PUSH as complete
+		if(rma != nullptr) { progress = rma->poll([this](const char* message) { deliver_unposted_transfer(message); }) || progress; }
+		return progress;
 	}
 
-	void buffer_transfer_manager::poll_incoming_transfers() {
-		MPI_Status status;
-		int flag;
-		MPI_Message msg;
-		MPI_Improbe(MPI_ANY_SOURCE, mpi_support::TAG_DATA_TRANSFER, MPI_COMM_WORLD, &flag, &msg, &status);
-		if(flag == 0) {
-			// No incoming transfers at the moment
-			return;
-		}
-		int count;
-		MPI_Get_count(&status, MPI_CHAR, &count);
-		const int data_size = count - sizeof(data_header);
+	bool buffer_transfer_manager::update_incoming_transfers() {
+		return incoming_transfers.test_some([this](const std::shared_ptr<incoming_transfer_handle>& t_handle) {
+			auto& transfer = *t_handle->transfer;
+			std::memcpy(&transfer.header, transfer.message.get(), sizeof(data_header));
+			const int tag = mpi_support::get_data_transfer_tag(transfer.push_cid);
+			posted_transfer_tags.at(transfer.source).erase(tag);
+			if(transfer.header.push_cid != transfer.push_cid) {
+				// The receive has been matched by another PUSH with the same tag (which MPI would have reported if its message were larger).
+				// Hand its data over, and probe for our own data instead.
+				auto& probed = probed_transfers[transfer.source][tag];
+				probed.erase(transfer.header.push_cid);
+				deliver_received_transfer(transfer.source, transfer.message.get());
+				probed.insert(transfer.push_cid);
+				pending_unposted_transfers[transfer.push_cid] = t_handle;
+				t_handle->transfer = nullptr;
+				return;
+			}
+			if(transfer_logger->should_log(log_level::trace)) { transfer_logger->trace("Received data for push {}", transfer.header.push_cid); }
+			t_handle->received = true;
+			if(transfer.header.shm_offset != inline_payload) {
+				shm_transport.sync();
+				const char* payload = shm_transport.get_peer_ptr(transfer.source, transfer.header.shm_offset);
+				if(t_handle->requested) {
+					write_data_to_buffer(transfer.header, payload);
+					t_handle->transfer = nullptr;
+					t_handle->complete = true;
+				} else {
+					// Copy the data out of shared memory, as the sender might be unable to make progress until we release it
+					transfer.message = staging_buffer(sizeof(data_header) + transfer.header.size);
+					std::memcpy(transfer.get_payload(), payload, transfer.header.size);
+				}
+				shm_transport.release_peer_payload(transfer.source, transfer.header.shm_offset);
+			} else if(t_handle->requested) {
+				write_data_to_buffer(transfer.header, transfer.get_payload());
+				t_handle->transfer = nullptr;
+				t_handle->complete = true;
+			}
+		});
+	}
 
-		auto transfer = std::make_unique<transfer_in>();
-		transfer->data.resize(data_size);
-		transfer->data_type = mpi_support::build_single_use_composite_type({{sizeof(data_header), &transfer->header}, {data_size, &transfer->data[0]}});
+	bool buffer_transfer_manager::receive_aggregated_transfers() {
+		bool progress = false;
+		while(true) {
+			int flag;
+			MPI_Message msg;
+			MPI_Status status;
+			MPI_Improbe(MPI_ANY_SOURCE, mpi_support::TAG_DATA_AGGREGATE, MPI_COMM_WORLD, &flag, &msg, &status);
+			if(flag == 0) break;
+			progress = true;
 
-		// Start receiving data
-		MPI_Imrecv(MPI_BOTTOM, 1, *transfer->data_type, &msg, &transfer->request);
-		incoming_transfers.push_back(std::move(transfer));
+			// Aggregated messages are small enough to be sent eagerly, so we can receive them right away
+			int count;
+			MPI_Get_count(&status, MPI_BYTE, &count);
+			staging_buffer message(static_cast<size_t>(count));
+			MPI_Mrecv(message.get(), count, MPI_BYTE, &msg, MPI_STATUS_IGNORE);
 
-		transfer_logger->trace("Receiving incoming data of size {} from {}", data_size, status.MPI_SOURCE);
+			for(size_t offset = 0; offset < static_cast<size_t>(count);) {
+				const char* part = message.get() + offset;
+				data_header header;
+				std::memcpy(&header, part, sizeof(data_header));
+				offset += get_aggregate_part_size(header.size);
+				deliver_unposted_transfer(part);
+			}
+		}
+		return progress;
 	}
 
-	void buffer_transfer_manager::update_incoming_transfers() {
-		for(auto it = incoming_transfers.begin(); it != incoming_transfers.end();) {
-			auto& transfer = *it;
-			int flag;
-			MPI_Test(&transfer->request, &flag, MPI_STATUS_IGNORE);
-			if(flag == 0) {
-				++it;
-				continue;
-			}
+	bool buffer_transfer_manager::receive_probed_transfers() {
+		bool progress = false;
+		for(auto& source_and_tags : probed_transfers) {
+			const node_id source = source_and_tags.first;
+			auto& tags = source_and_tags.second;
+			for(auto it = tags.begin(); it != tags.end();) {
+				auto& push_cids = it->second;
+				while(!push_cids.empty()) {
+					int flag;
+					MPI_Message msg;
+					MPI_Status status;
+					MPI_Improbe(static_cast<int>(source), it->first, MPI_COMM_WORLD, &flag, &msg, &status);
+					if(flag == 0) break;
+					progress = true;
 
-			// Check whether we already have an await push request
-			std::shared_ptr<incoming_transfer_handle> t_handle = nullptr;
-			if(push_blackboard.count(transfer->header.push_cid) != 0) {
-				t_handle = push_blackboard[transfer->header.push_cid];
-				push_blackboard.erase(transfer->header.push_cid);
-				assert(t_handle.use_count() > 1 && "Dangling await push request");
-				t_handle->transfer = std::move(*it);
-				write_data_to_buffer(*t_handle->transfer);
-				t_handle->complete = true;
-			} else {
-				t_handle = std::make_shared<incoming_transfer_handle>();
-				push_blackboard[transfer->header.push_cid] = t_handle;
-				t_handle->transfer = std::move(*it);
-				t_handle->complete = true;
+					int count;
+					MPI_Get_count(&status, MPI_BYTE, &count);
+					staging_buffer message(static_cast<size_t>(count));
+					MPI_Mrecv(message.get(), count, MPI_BYTE, &msg, MPI_STATUS_IGNORE);
+
+					// This may also be the data of a PUSH whose AWAIT_PUSH hasn't been prepared yet
+					data_header header;
+					std::memcpy(&header, message.get(), sizeof(data_header));
+					push_cids.erase(header.push_cid);
+					deliver_received_transfer(source, message.get());
+				}
+				it = push_cids.empty() ? tags.erase(it) : std::next(it);
 			}
-			it = incoming_transfers.erase(it);
 		}
+		return progress;
 	}
 
-	void buffer_transfer_manager::update_outgoing_transfers() {
-		for(auto it = outgoing_transfers.begin(); it != outgoing_transfers.end();) {
-			auto& t = *it;
-			int flag;
-			MPI_Test(&t->request, &flag, MPI_STATUS_IGNORE);
-			if(flag == 0) {
+	void buffer_transfer_manager::deliver_received_transfer(node_id source, const char* message) {
+		data_header header;
+		std::memcpy(&header, message, sizeof(data_header));
+		if(header.shm_offset == inline_payload) {
+			deliver_unposted_transfer(message);
+			return;
+		}
+
+		// Copy the payload out of shared memory right away, so the sender can reuse that part of its segment
+		const size_t shm_offset = header.shm_offset;
+		header.shm_offset = inline_payload;
+		staging_buffer inline_message(sizeof(data_header) + header.size);
+		std::memcpy(inline_message.get(), &header, sizeof(data_header));
+		shm_transport.sync();
+		std::memcpy(inline_message.get() + sizeof(data_header), shm_transport.get_peer_ptr(source, shm_offset), header.size);
+		shm_transport.release_peer_payload(source, shm_offset);
+		deliver_unposted_transfer(inline_message.get());
+	}
+
+	void buffer_transfer_manager::deliver_unposted_transfer(const char* message) {
+		data_header header;
+		std::memcpy(&header, message, sizeof(data_header));
+		if(transfer_logger->should_log(log_level::trace)) { transfer_logger->trace("Received data for push {}", header.push_cid); }
+
+		std::shared_ptr<incoming_transfer_handle> t_handle;
+		if(pending_unposted_transfers.count(header.push_cid) != 0) {
+			t_handle = std::move(pending_unposted_transfers.at(header.push_cid));
+			pending_unposted_transfers.erase(header.push_cid);
+		} else {
+			// The AWAIT_PUSH hasn't been prepared yet
+			assert(push_blackboard.count(header.push_cid) == 0);
+			t_handle = std::make_shared<incoming_transfer_handle>();
+			push_blackboard[header.push_cid] = t_handle;
+		}
+
+		t_handle->received = true;
+		if(t_handle->requested) {
+			write_data_to_buffer(header, message + sizeof(data_header));
+			t_handle->complete = true;
+			return;
+		}
+		// Keep a copy around until the data is requested
+		t_handle->transfer = std::make_unique<transfer_in>();
+		t_handle->transfer->header = header;
+		t_handle->transfer->message = staging_buffer(sizeof(data_header) + header.size);
+		std::memcpy(t_handle->transfer->message.get(), message, sizeof(data_header) + header.size);
+	}
+
+	bool buffer_transfer_manager::update_outgoing_transfers() {
+		bool progress = false;
+		for(auto it = unsent_transfers.begin(); it != unsent_transfers.end();) {
+			if(!try_send(*it)) {
 				++it;
 				continue;
 			}
-			t->handle->complete = true;
-			it = outgoing_transfers.erase(it);
+			it = unsent_transfers.erase(it);
+			progress = true;
 		}
+
+		progress = outgoing_transfers.test_some([this](const std::unique_ptr<transfer_out>& t) {
+			if(t->tp == transport::RMA) { rma->publish(t->rma_entry); }
+			t->handle->complete = true;
+			outgoing_bytes -= t->size;
+		}) || progress;
+
+		progress = outgoing_aggregates.test_some([this](const std::unique_ptr<aggregate_out>& a) {
+			for(auto& h : a->handles) {
+				h->complete = true;
+			}
+			outgoing_bytes -= a->size;
+		}) || progress;
+		return progress;
 	}
 
-	void buffer_transfer_manager::write_data_to_buffer(transfer_in& transfer) {
-		// TODO: Same as in push() - this blocks the caller until data is submitted to MPI
-		const auto& header = transfer.header;
-		const detail::raw_data_handle dh{&transfer.data[0], cl::sycl::range<3>(header.subrange.range[0], header.subrange.range[1], header.subrange.range[2]),
+	void buffer_transfer_manager::write_data_to_buffer(const data_header& header, const char* payload) {
+		// TODO: This blocks the caller until the data has been written to the buffer
+		const detail::raw_data_handle dh{const_cast<char*>(payload),
+		    cl::sycl::range<3>(header.subrange.range[0], header.subrange.range[1], header.subrange.range[2]),
 		    cl::sycl::id<3>(header.subrange.offset[0], header.subrange.offset[1], header.subrange.offset[2])};
-		// In some rare situations the local runtime might not yet know about this buffer. Busy wait until it does.
-		while(!runtime::get_instance().has_buffer(header.bid)) {}
 		runtime::get_instance().set_buffer_data(header.bid, dh);
 	}
 
@@ -0,0 +1,153 @@
+#include "command_batch.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace celerity {
+namespace detail {
+
+	namespace {
+
+		void write_varint(std::vector<unsigned char>& out, uint64_t value) {
+			while(value >= 0x80) {
+				out.push_back(static_cast<unsigned char>(value | 0x80));
+				value >>= 7;
+			}
+			out.push_back(static_cast<unsigned char>(value));
+		}
+
+		uint64_t read_varint(const unsigned char*& pos, const unsigned char* end) {
+			uint64_t value = 0;
+			for(unsigned shift = 0;; shift += 7) {
+				assert(pos < end && shift < 64);
+				const unsigned char byte = *pos++;
+				value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+				if((byte & 0x80) == 0) break;
+			}
+			return value;
+		}
+
+		// Ids are encoded as (zigzag-encoded) signed differences to a reference id, which is usually close by.
+		void write_id_delta(std::vector<unsigned char>& out, size_t id, size_t reference) {
+			const auto delta = static_cast<int64_t>(id - reference);
+			write_varint(out, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+		}
+
+		size_t read_id_delta(const unsigned char*& pos, const unsigned char* end, size_t reference) {
+			const uint64_t zigzag = read_varint(pos, end);
+			const auto delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+			return reference + static_cast<size_t>(delta);
+		}
+
+		// Only dimensions up to the last one that differs from a default (zero offset, unit range) are encoded.
+		void write_subrange(std::vector<unsigned char>& out, const command_subrange& sr) {
+			unsigned dims = 3;
+			while(dims > 1 && sr.offset[dims - 1] == 0 && sr.range[dims - 1] == 1) {
+				dims--;
+			}
+			out.push_back(static_cast<unsigned char>(dims));
+			for(unsigned d = 0; d < dims; ++d) {
+				write_varint(out, sr.offset[d]);
+				write_varint(out, sr.range[d]);
+			}
+		}
+
+		command_subrange read_subrange(const unsigned char*& pos, const unsigned char* end) {
+			assert(pos < end);
+			const unsigned dims = *pos++;
+			assert(dims >= 1 && dims <= 3);
+			command_subrange sr;
+			for(unsigned d = 0; d < dims; ++d) {
+				sr.offset[d] = read_varint(pos, end);
+				sr.range[d] = read_varint(pos, end);
+			}
+			return sr;
+		}
+
+	} // namespace
+
+	void command_batch::add(const command_pkg& pkg, const std::vector<command_id>& dependencies) {
+		data.push_back(static_cast<unsigned char>(pkg.cmd));
+		write_varint(data, pkg.tid);
+		write_id_delta(data, pkg.cid, previous_cid);
+
+		switch(pkg.cmd) {
+		case command::COMPUTE:
+			write_subrange(data, pkg.data.compute.subrange);
+			write_varint(data, pkg.data.compute.fused_tasks);
+			break;
+		case command::PUSH:
+			write_varint(data, pkg.data.push.bid);
+			write_varint(data, pkg.data.push.target);
+			write_subrange(data, pkg.data.push.subrange);
+			break;
+		case command::AWAIT_PUSH:
+			write_varint(data, pkg.data.await_push.bid);
+			write_varint(data, pkg.data.await_push.source);
+			write_id_delta(data, pkg.data.await_push.source_cid, pkg.cid);
+			write_subrange(data, pkg.data.await_push.subrange);
+			break;
+		default: break;
+		}
+
+		// Dependencies are commands that have been generated shortly before, so their ids are typically close to that of the command itself
+		write_varint(data, dependencies.size());
+		for(const auto& d : dependencies) {
+			write_id_delta(data, d, pkg.cid);
+		}
+
+		previous_cid = pkg.cid;
+		command_count++;
+	}
+
+	std::vector<unsigned char> command_batch::take_data() {
+		std::vector<unsigned char> result;
+		std::swap(result, data);
+		command_count = 0;
+		previous_cid = 0;
+		return result;
+	}
+
+	void command_batch::recycle(std::vector<unsigned char> buffer) {
+		if(!data.empty() || data.capacity() >= buffer.capacity()) return;
+		buffer.clear();
+		data = std::move(buffer);
+	}
+
+	void command_batch::decode_command(
+	    const unsigned char*& pos, const unsigned char* end, command_id& previous_cid, command_pkg& pkg, std::vector<command_id>& dependencies) {
+		assert(pos < end);
+		pkg.cmd = static_cast<command>(*pos++);
+		pkg.tid = read_varint(pos, end);
+		pkg.cid = read_id_delta(pos, end, previous_cid);
+		pkg.data = command_data{};
+
+		switch(pkg.cmd) {
+		case command::COMPUTE:
+			pkg.data.compute.subrange = read_subrange(pos, end);
+			pkg.data.compute.fused_tasks = read_varint(pos, end);
+			break;
+		case command::PUSH:
+			pkg.data.push.bid = read_varint(pos, end);
+			pkg.data.push.target = read_varint(pos, end);
+			pkg.data.push.subrange = read_subrange(pos, end);
+			break;
+		case command::AWAIT_PUSH:
+			pkg.data.await_push.bid = read_varint(pos, end);
+			pkg.data.await_push.source = read_varint(pos, end);
+			pkg.data.await_push.source_cid = read_id_delta(pos, end, pkg.cid);
+			pkg.data.await_push.subrange = read_subrange(pos, end);
+			break;
+		default: break;
+		}
+
+		dependencies.resize(read_varint(pos, end));
+		for(auto& d : dependencies) {
+			d = read_id_delta(pos, end, pkg.cid);
+		}
+
+		previous_cid = pkg.cid;
+	}
+
+} // namespace detail
+} // namespace celerity
@@ -1,6 +1,7 @@
 #include "config.h"
 
 #include <cstdlib>
+#include <numeric>
 #include <sstream>
 #include <vector>
 
@@ -38,6 +39,14 @@ std::pair<bool, size_t> parse_uint(const char* str) {
 	return {false, 0};
 }
 
+std::pair<bool, double> parse_double(const char* str) {
+	errno = 0;
+	char* end = nullptr;
+	const auto value = std::strtod(str, &end);
+	if(errno == 0 && end != str) { return {true, value}; }
+	return {false, 0.0};
+}
+
 namespace celerity {
 namespace detail {
 	config::config(int* argc, char** argv[], logger& logger) {
@@ -104,7 +113,8 @@ namespace detail {
 				MPI_Comm_rank(node_comm, &node_rank);
 
 				std::vector<std::string> values;
-				boost::split(values, result.second, [](char c) { return c == ' '; });
+				// Values may be separated by any amount of whitespace
+				boost::split(values, boost::trim_copy(result.second), boost::is_space(), boost::token_compress_on);
 
 				if(node_rank > static_cast<long>(values.size()) - 2) {
 					throw std::runtime_error(
@@ -152,6 +162,135 @@ namespace detail {
 				if(parsed.first) { forced_work_group_size = parsed.second; }
 			}
 		}
+
+		// ----------------------------- CELERITY_CHUNKS_PER_NODE -----------------------------
+
+		{
+			const auto result = get_env("CELERITY_CHUNKS_PER_NODE");
+			if(result.first) {
+				const auto parsed = parse_uint(result.second.c_str());
+				if(parsed.first && parsed.second > 0) {
+					chunks_per_node = parsed.second;
+				} else {
+					logger.warn("CELERITY_CHUNKS_PER_NODE must be a positive integer - will be ignored");
+				}
+			}
+		}
+
+		// ----------------------------- CELERITY_LOAD_BALANCING ------------------------------
+
+		{
+			const auto result = get_env("CELERITY_LOAD_BALANCING");
+			if(result.first) { enable_load_balancing = result.second == "1"; }
+		}
+
+		// ------------------------------- CELERITY_LB_DAMPING --------------------------------
+
+		{
+			const auto result = get_env("CELERITY_LB_DAMPING");
+			if(result.first) {
+				const auto parsed = parse_double(result.second.c_str());
+				if(parsed.first && parsed.second >= 0.0 && parsed.second < 1.0) {
+					load_balancing_damping = parsed.second;
+				} else {
+					logger.warn("CELERITY_LB_DAMPING must be a value in [0, 1) - will be ignored");
+				}
+			}
+		}
+
+		// ----------------------------- CELERITY_SPLIT_WEIGHTS -------------------------------
+
+		{
+			const auto result = get_env("CELERITY_SPLIT_WEIGHTS");
+			if(result.first) {
+				std::vector<std::string> values;
+				// Values may be separated by any amount of whitespace
+				boost::split(values, boost::trim_copy(result.second), boost::is_space(), boost::token_compress_on);
+				std::vector<double> weights;
+				for(auto& v : values) {
+					const auto parsed = parse_double(v.c_str());
+					if(!parsed.first || parsed.second < 0.0) {
+						weights.clear();
+						break;
+					}
+					weights.push_back(parsed.second);
+				}
+				if(std::accumulate(weights.cbegin(), weights.cend(), 0.0) <= 0.0) {
+					logger.warn("CELERITY_SPLIT_WEIGHTS contains invalid value(s) - will be ignored");
+				} else {
+					split_weights = weights;
+				}
+			}
+		}
+
+		// ------------------------------ CELERITY_TASK_FUSION --------------------------------
+
+		{
+			const auto result = get_env("CELERITY_TASK_FUSION");
+			if(result.first) {
+				const auto parsed = parse_uint(result.second.c_str());
+				if(parsed.first && parsed.second > 0) {
+					max_fused_tasks = parsed.second;
+				} else {
+					logger.warn("CELERITY_TASK_FUSION must be a positive integer - will be ignored");
+				}
+			}
+		}
+
+		// -------------------------- CELERITY_MASTER_PARTICIPATION ---------------------------
+
+		{
+			const auto result = get_env("CELERITY_MASTER_PARTICIPATION");
+			if(result.first) {
+				if(result.second == "exclude") {
+					master_participation = master_participation_config{false, 0.0};
+				} else if(result.second == "auto") {
+					master_participation = master_participation_config{true, 1.0};
+				} else {
+					const auto parsed = parse_double(result.second.c_str());
+					if(parsed.first && parsed.second >= 0.0 && parsed.second <= 1.0) {
+						master_participation = master_participation_config{false, parsed.second};
+					} else {
+						logger.warn("CELERITY_MASTER_PARTICIPATION must be \"exclude\", \"auto\" or a value in [0, 1] - will be ignored");
+					}
+				}
+			}
+		}
+
+		// ---------------------------- CELERITY_SHM_SEGMENT_SIZE -----------------------------
+
+		{
+			const auto result = get_env("CELERITY_SHM_SEGMENT_SIZE");
+			if(result.first) {
+				const auto parsed = parse_uint(result.second.c_str());
+				if(parsed.first) {
+					shm_segment_size = parsed.second * 1024 * 1024;
+				} else {
+					logger.warn("CELERITY_SHM_SEGMENT_SIZE must be a non-negative integer - will be ignored");
+				}
+			}
+		}
+
+		// ------------------------------ CELERITY_RMA_TRANSFERS ------------------------------
+
+		{
+			const auto result = get_env("CELERITY_RMA_TRANSFERS");
+			if(result.first) { enable_rma_transfers = result.second == "1"; }
+		}
+
+		// ---------------------------- CELERITY_MAX_COMPUTE_JOBS -----------------------------
+
+		{
+			const auto result = get_env("CELERITY_MAX_COMPUTE_JOBS");
+			if(result.first) {
+				const auto parsed = parse_uint(result.second.c_str());
+				if(parsed.first && parsed.second > 0) {
+					max_compute_jobs = parsed.second;
+				} else {
+					logger.warn("CELERITY_MAX_COMPUTE_JOBS must be a positive integer - will be ignored");
+				}
+			}
+		}
 	}
 
 } // namespace detail
@@ -1,12 +1,11 @@
 #include "executor.h"
 
-#include <queue>
+#include <algorithm>
+#include <cstring>
+#include <functional>
 
+#include "command_batch.h"
 #include "distr_queue.h"
-#include "mpi_support.h"
-
-// TODO: Get rid of this. (This could potentialy even cause deadlocks on large clusters)
-constexpr size_t MAX_CONCURRENT_JOBS = 20;
 
 namespace celerity {
 namespace detail {
@@ -22,12 +21,83 @@ namespace detail {
 		running = false;
 	}
 
-	executor::executor(device_queue& queue, task_manager& tm, std::shared_ptr<logger> execution_logger)
-	    : queue(queue), task_mngr(tm), execution_logger(execution_logger) {
-		btm = std::make_unique<buffer_transfer_manager>(execution_logger);
+	constexpr size_t idle_backoff::spin_iterations;
+	constexpr size_t idle_backoff::yield_iterations;
+	constexpr std::chrono::microseconds idle_backoff::max_sleep;
+
+	void idle_backoff::idle(duration_metric& metric) {
+		idle_iterations++;
+		if(idle_iterations <= spin_iterations) return;
+		if(idle_iterations <= spin_iterations + yield_iterations) {
+			std::this_thread::yield();
+			return;
+		}
+		const auto exponent = std::min<size_t>(idle_iterations - spin_iterations - yield_iterations - 1, 16);
+		const auto sleep = std::min(std::chrono::microseconds(1 << exponent), max_sleep);
+		metric.resume();
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake_up.wait_for(lock, sleep, [this] { return notified; });
+			notified = false;
+		}
+		metric.pause();
+	}
+
+	void idle_backoff::notify() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			notified = true;
+		}
+		wake_up.notify_one();
+	}
+
+	constexpr size_t admission_control::default_max_running_compute_jobs;
+	constexpr size_t admission_control::default_max_outgoing_transfer_bytes;
+
+	bool admission_control::admit(command cmd, size_t running_compute_jobs, size_t outgoing_transfer_bytes) const {
+		switch(cmd) {
+		// Other nodes may be blocked on our outgoing data, so we always have to make progress on PUSHes.
+		// We limit the amount of data that is staged for sending at once, but always admit a PUSH if nothing else is in flight.
+		case command::PUSH: return outgoing_transfer_bytes == 0 || outgoing_transfer_bytes < max_outgoing_transfer_bytes;
+		case command::COMPUTE: return running_compute_jobs < max_running_compute_jobs;
+		default: return true;
+		}
+	}
+
+	executor::executor(device_queue& queue, task_manager& tm, std::shared_ptr<logger> execution_logger, std::unique_ptr<transport> ctrl_transport,
+	    std::unique_ptr<buffer_transfer_manager> btm, bool report_throughput, size_t max_running_compute_jobs)
+	    : queue(queue), task_mngr(tm), btm(std::move(btm)), execution_logger(execution_logger), admission(max_running_compute_jobs),
+	      local_nid(ctrl_transport->get_local_nid()), report_throughput(report_throughput), ctrl_transport(std::move(ctrl_transport)) {
 		metrics.initial_idle.resume();
 	}
 
+	constexpr size_t executor::local_command_queue_capacity;
+
+	void executor::enable_local_commands() {
+		assert(!exec_thrd.joinable());
+		local_commands = std::make_unique<local_command_queue>(local_command_queue_capacity);
+	}
+
+	void executor::enqueue_local_command(const command_pkg& pkg, const std::vector<command_id>& dependencies) {
+		assert(local_commands != nullptr);
+		local_command cmd{pkg, dependencies};
+		// The executor drains the queue in every iteration, so we won't have to wait for long
+		while(!local_commands->try_push(cmd)) {
+			std::this_thread::yield();
+		}
+		backoff.notify();
+	}
+
+	void executor::end_local_flush() {
+		assert(local_commands != nullptr);
+		local_command marker;
+		marker.ends_flush = true;
+		while(!local_commands->try_push(marker)) {
+			std::this_thread::yield();
+		}
+		backoff.notify();
+	}
+
 	void executor::startup() { exec_thrd = std::thread(&executor::run, this); }
 
 	void executor::shutdown() {
@@ -36,103 +106,58 @@ namespace detail {
 		execution_logger->trace(logger_map{{"initialIdleTime", std::to_string(metrics.initial_idle.get().count())}});
 		execution_logger->trace(logger_map{{"computeIdleTime", std::to_string(metrics.compute_idle.get().count())}});
 		execution_logger->trace(logger_map{{"starvationTime", std::to_string(metrics.starvation.get().count())}});
+		execution_logger->trace(logger_map{{"backoffTime", std::to_string(metrics.backoff.get().count())}});
 	}
 
 	void executor::run() {
 		bool done = false;
 
-		struct command_info {
-			command_pkg pkg;
-			std::vector<command_id> dependencies;
-		};
-		std::queue<command_info> command_queue;
-
 		while(!done || !jobs.empty()) {
 			// We poll transfers from here (in the same thread, interleaved with job updates),
 			// as it allows us to omit any sort of locking when interacting with the BTM through jobs.
 			// This actually makes quite a big difference, especially for lots of small transfers.
 			// The BTM uses non-blocking MPI routines internally, making this a relatively cheap operation.
-			btm->poll();
+			// We also keep track of whether anything happened in this iteration. If not, we back off to avoid needlessly burning CPU cycles.
+			bool made_progress = btm != nullptr && btm->poll();
 
-			std::vector<command_id> ready_jobs;
-			for(auto it = jobs.begin(); it != jobs.end();) {
-				auto& job_handle = it->second;
-
-				if(job_handle.unsatisfied_dependencies > 0) {
-					++it;
-					continue;
+			// Only running jobs need to be updated; blocked jobs are made ready by their last remaining dependency upon completion.
+			for(auto handle = running_jobs.front(); handle != nullptr;) {
+				const auto next = handle->next;
+				if(!handle->job->is_done()) { handle->job->update(); }
+				if(handle->job->is_done()) {
+					complete_job(*handle);
+					made_progress = true;
 				}
+				handle = next;
+			}
 
-				if(!job_handle.job->is_running()) {
-					if(std::find(ready_jobs.cbegin(), ready_jobs.cend(), it->first) == ready_jobs.cend()) { ready_jobs.push_back(it->first); }
-					++it;
-					continue;
-				}
+			// Make sure to start any PUSH jobs before other jobs, as on some platforms copying data from a compute device while
+			// also reading it from within a kernel is not supported. To avoid stalling other nodes, we thus perform the PUSH first.
+			made_progress |= start_ready_jobs(ready_pushes);
+			// Small PUSHes to the same node are sent together, so we send them only once all ready PUSHes have been started
+			if(btm != nullptr) { btm->send_aggregated_pushes(); }
+			made_progress |= start_ready_jobs(ready_jobs);
 
-				if(!job_handle.job->is_done()) {
-					job_handle.job->update();
-					++it;
-				} else {
-					for(const auto& d : job_handle.dependants) {
-						assert(jobs.count(d) == 1);
-						jobs[d].unsatisfied_dependencies--;
-						if(jobs[d].unsatisfied_dependencies == 0) { ready_jobs.push_back(d); }
-					}
-					job_count_by_cmd[job_handle.cmd]--;
-					it = jobs.erase(it);
-				}
-			}
+			made_progress |= local_commands != nullptr ? receive_local_commands(done) : receive_command_batches(done);
 
-			// Process newly available jobs
-			if(!ready_jobs.empty()) {
-				// Make sure to start any PUSH jobs before other jobs, as on some platforms copying data from a compute device while
-				// also reading it from within a kernel is not supported. To avoid stalling other nodes, we thus perform the PUSH first.
-				std::sort(ready_jobs.begin(), ready_jobs.end(),
-				    [this](command_id a, command_id b) { return jobs[a].cmd == command::PUSH && jobs[b].cmd != command::PUSH; });
-				for(command_id cid : ready_jobs) {
-					jobs[cid].job->start();
-					jobs[cid].job->update();
-					job_count_by_cmd[jobs[cid].cmd]++;
-				}
-			}
+			send_progress_report();
+			if(throughput_cb || completion_cb) { poll_progress_reports(); }
 
-			MPI_Status status;
-			int flag;
-			MPI_Message msg;
-			MPI_Improbe(MPI_ANY_SOURCE, mpi_support::TAG_CMD, MPI_COMM_WORLD, &flag, &msg, &status);
-			if(flag == 1) {
-				// Commands should be small enough to block here (TODO: Re-evaluate this now that we also transfer dependencies)
-				command_queue.emplace<command_info>({});
-				auto& pkg = command_queue.back().pkg;
-				auto& dependencies = command_queue.back().dependencies;
-				int count;
-				MPI_Get_count(&status, MPI_CHAR, &count);
-				const size_t deps_size = count - sizeof(command_pkg);
-				dependencies.resize(deps_size / sizeof(command_id));
-				const auto data_type = mpi_support::build_single_use_composite_type({{sizeof(command_pkg), &pkg}, {deps_size, dependencies.data()}});
-				MPI_Mrecv(MPI_BOTTOM, 1, *data_type, &msg, &status);
-
-				if(!first_command_received) {
-					metrics.initial_idle.pause();
-					metrics.compute_idle.resume();
-					first_command_received = true;
-				}
-			}
+			if(first_command_received) { update_metrics(); }
 
-			if(jobs.size() < MAX_CONCURRENT_JOBS && !command_queue.empty()) {
-				const auto info = command_queue.front();
-				command_queue.pop();
-				if(info.pkg.cmd == command::SHUTDOWN) {
-					assert(command_queue.empty());
-					done = true;
-				} else {
-					handle_command(info.pkg, info.dependencies);
-				}
+			if(made_progress) {
+				backoff.reset();
+			} else {
+				backoff.idle(metrics.backoff);
 			}
+		}
 
-			if(first_command_received) { update_metrics(); }
+		// Progress reports are tiny, so this won't block for long (if at all).
+		while(ctrl_transport->get_pending_send_count() > 0) {
+			ctrl_transport->poll_sends([](node_id, std::vector<unsigned char>) {});
 		}
 
+		assert(blocked_jobs.empty() && ready_pushes.empty() && ready_jobs.empty() && running_jobs.empty());
 #ifndef NDEBUG
 		for(const auto it : job_count_by_cmd) {
 			assert(it.second == 0);
@@ -140,16 +165,155 @@ namespace detail {
 #endif
 	}
 
+	bool executor::start_ready_jobs(job_list& ready) {
+		bool started_any = false;
+		for(auto handle = ready.front(); handle != nullptr;) {
+			const auto next = handle->next;
+			// Jobs that are not admitted right now remain ready and will be reconsidered in the next iteration
+			if(admission.admit(handle->cmd, job_count_by_cmd[command::COMPUTE], btm != nullptr ? btm->get_outgoing_bytes() : 0)) {
+				ready.erase(*handle);
+				handle->job->start();
+				handle->job->update();
+				job_count_by_cmd[handle->cmd]++;
+				running_jobs.push_back(*handle);
+				started_any = true;
+			}
+			handle = next;
+		}
+		return started_any;
+	}
+
+	void executor::complete_job(job_handle& handle) {
+		if(report_throughput && handle.cmd == command::COMPUTE) { record_compute_throughput(*handle.job); }
+		for(const auto& d : handle.dependants) {
+			assert(jobs.count(d) == 1);
+			auto& dependant = jobs.at(d);
+			assert(dependant.unsatisfied_dependencies > 0);
+			if(--dependant.unsatisfied_dependencies == 0) {
+				blocked_jobs.erase(dependant);
+				make_ready(dependant);
+			}
+		}
+		handle.dependants.clear();
+		spare_dependants.push_back(std::move(handle.dependants));
+		job_count_by_cmd[handle.cmd]--;
+		running_jobs.erase(handle);
+		const command_id cid = handle.cid; // Don't pass a reference into the element being erased
+		jobs.erase(cid);
+	}
+
+	bool executor::receive_local_commands(bool& done) {
+		bool received_any = false;
+		while(local_commands->try_pop(received_local_command)) {
+			if(received_local_command.ends_flush) {
+				received_cids_end = pending_cids_end;
+				continue;
+			}
+			process_command(received_local_command.pkg, received_local_command.dependencies, done);
+			received_any = true;
+		}
+		return received_any;
+	}
+
+	bool executor::receive_command_batches(bool& done) {
+		// Drain all pending command batches. Each batch contains all commands for this node that resulted from a single flush.
+		bool received_any = false;
+		node_id source;
+		while(ctrl_transport->try_receive(transport::channel::COMMANDS, source, received_message)) {
+			received_any = true;
+			command_batch::decode(received_message.data(), received_message.size(), received_dependencies,
+			    [this, &done](const command_pkg& pkg, const std::vector<command_id>& dependencies) { process_command(pkg, dependencies, done); });
+			received_cids_end = pending_cids_end;
+		}
+		return received_any;
+	}
+
+	void executor::process_command(const command_pkg& pkg, const std::vector<command_id>& dependencies, bool& done) {
+		if(!first_command_received) {
+			metrics.initial_idle.pause();
+			metrics.compute_idle.resume();
+			first_command_received = true;
+		}
+
+		// Every command immediately becomes a job, so its dependencies can be tracked. Limiting the number of
+		// concurrently executing jobs is up to admission control, which is applied when starting ready jobs.
+		if(pkg.cmd == command::SHUTDOWN) {
+			done = true;
+		} else {
+			assert(!done);
+			handle_command(pkg, dependencies);
+			received_cids.push_back(pkg.cid);
+			std::push_heap(received_cids.begin(), received_cids.end(), std::greater<command_id>());
+			pending_cids_end = std::max<command_id>(pending_cids_end, pkg.cid + 1);
+		}
+	}
+
 	void executor::handle_command(const command_pkg& pkg, const std::vector<command_id>& dependencies) {
+		assert((btm != nullptr || (pkg.cmd != command::PUSH && pkg.cmd != command::AWAIT_PUSH)) && "Data transfers require a buffer_transfer_manager");
 		switch(pkg.cmd) {
-		case command::PUSH: create_job<push_job>(pkg, dependencies, *btm); break;
-		case command::AWAIT_PUSH: create_job<await_push_job>(pkg, dependencies, *btm); break;
-		case command::COMPUTE: create_job<compute_job>(pkg, dependencies, queue, task_mngr); break;
-		case command::MASTER_ACCESS: create_job<master_access_job>(pkg, dependencies, task_mngr); break;
+		case command::PUSH: create_job(pkg, dependencies, push_job_pool, *btm); break;
+		case command::AWAIT_PUSH: {
+			btm->prepare_await_push(pkg);
+			create_job(pkg, dependencies, await_push_job_pool, *btm);
+		} break;
+		case command::COMPUTE: create_job(pkg, dependencies, compute_job_pool, queue, task_mngr); break;
+		case command::MASTER_ACCESS: create_job(pkg, dependencies, master_access_job_pool, task_mngr); break;
 		default: { assert(false && "Unexpected command"); }
 		}
 	}
 
+	void executor::record_compute_throughput(const worker_job& job) {
+		const auto& compute = job.get_pkg().data.compute;
+		const auto& sr = compute.subrange;
+		pending_report.work_items += sr.range[0] * sr.range[1] * sr.range[2] * (1 + compute.fused_tasks);
+		pending_report.duration += job.get_execution_time().count();
+	}
+
+	command_id executor::get_completed_watermark() {
+		while(!received_cids.empty() && jobs.count(received_cids.front()) == 0) {
+			std::pop_heap(received_cids.begin(), received_cids.end(), std::greater<command_id>());
+			received_cids.pop_back();
+		}
+		// Commands of an incomplete flush may have ids below those of pending ones
+		return received_cids.empty() ? received_cids_end : std::min(received_cids.front(), received_cids_end);
+	}
+
+	void executor::send_progress_report() {
+		const command_id watermark = get_completed_watermark();
+		if(pending_report.work_items == 0 && watermark == reported_watermark) return;
+
+		// There's no need to go through the transport on the master node
+		if(local_nid == 0) {
+			if(pending_report.work_items > 0 && throughput_cb) {
+				throughput_cb(local_nid, pending_report.work_items, std::chrono::microseconds(pending_report.duration));
+			}
+			if(completion_cb) { completion_cb(local_nid, watermark); }
+			pending_report = {0, 0, 0};
+			reported_watermark = watermark;
+			return;
+		}
+
+		ctrl_transport->poll_sends([this](node_id, std::vector<unsigned char> buffer) { report_buffer = std::move(buffer); });
+		if(ctrl_transport->get_pending_send_count() > 0) return;
+		pending_report.completed_watermark = watermark;
+		report_buffer.resize(sizeof(progress_report));
+		std::memcpy(report_buffer.data(), &pending_report, sizeof(progress_report));
+		pending_report = {0, 0, 0};
+		reported_watermark = watermark;
+		ctrl_transport->send(0, transport::channel::PROGRESS_REPORTS, std::move(report_buffer));
+	}
+
+	void executor::poll_progress_reports() {
+		node_id nid;
+		while(ctrl_transport->try_receive(transport::channel::PROGRESS_REPORTS, nid, received_message)) {
+			assert(received_message.size() == sizeof(progress_report));
+			progress_report report;
+			std::memcpy(&report, received_message.data(), sizeof(progress_report));
+			if(report.work_items > 0 && throughput_cb) { throughput_cb(nid, report.work_items, std::chrono::microseconds(report.duration)); }
+			if(completion_cb) { completion_cb(nid, report.completed_watermark); }
+		}
+	}
+
 	void executor::update_metrics() {
 		if(job_count_by_cmd[command::COMPUTE] == 0) {
 			if(!metrics.compute_idle.is_running()) { metrics.compute_idle.resume(); }
@@ -1,6 +1,6 @@
 #include "graph_builder.h"
 
-#include <queue>
+#include <algorithm>
 
 #include "graph_utils.h"
 
@@ -9,7 +9,7 @@ namespace detail {
 
 	graph_builder::graph_builder(command_dag& command_graph) : command_graph(command_graph) {}
 
-	command_id graph_builder::add_command(cdag_vertex a, cdag_vertex b, node_id nid, task_id tid, command cmd, command_data data, std::string label) {
+	command_id graph_builder::add_command(cdag_vertex a, cdag_vertex b, node_id nid, task_id tid, command cmd, command_data data) {
 		add_command_op add;
 		add.a = a;
 		add.b = b;
@@ -18,7 +18,6 @@ namespace detail {
 		add.cid = GRAPH_PROP(command_graph, next_cmd_id)++;
 		add.cmd = cmd;
 		add.data = data;
-		add.label = label;
 		graph_ops.emplace_back<graph_op>({graph_op_type::ADD_COMMAND, add});
 		return add.cid;
 	}
@@ -30,30 +29,12 @@ namespace detail {
 
 	std::vector<command_id> graph_builder::get_commands(task_id tid, command cmd) const {
 		std::vector<command_id> result;
-		auto& tv = GRAPH_PROP(command_graph, task_vertices)[tid];
-
-		// Iterate over all vertices within this task
-		// TODO: We may want to move this functionality into graph_utils
-		std::queue<cdag_vertex> cmd_queue;
-		std::unordered_set<cdag_vertex> queued_cmds;
-		cmd_queue.push(tv.first);
-		queued_cmds.insert(tv.first);
-
-		while(!cmd_queue.empty()) {
-			const auto v = cmd_queue.front();
-			cmd_queue.pop();
-			auto& cmd_v = command_graph[v];
-			if(cmd_v.cmd == cmd) { result.push_back(cmd_v.cid); }
-
-			graph_utils::for_successors(command_graph, v, [tv, tid, &queued_cmds, &cmd_queue, this](cdag_vertex s, cdag_edge) {
-				if(command_graph[s].tid == tid && s != tv.second && queued_cmds.count(s) == 0) {
-					cmd_queue.push(s);
-					queued_cmds.insert(s);
-				}
-				return true;
-			});
+		const auto& task_commands = GRAPH_PROP(command_graph, task_commands);
+		const auto it = task_commands.find(tid);
+		if(it == task_commands.end()) return result;
+		for(const auto v : it->second) {
+			if(command_graph[v].cmd == cmd) { result.push_back(command_graph[v].cid); }
 		}
-
 		return result;
 	}
 
@@ -89,7 +70,7 @@ namespace detail {
 
 		for(auto i = 0u; i < chunks.size(); ++i) {
 			command_data data{};
-			data.compute = {command_subrange(chunks[i])};
+			data.compute = {command_subrange(chunks[i]), 0};
 			add_command(tv.first, tv.second, nodes[i], cmdv.tid, command::COMPUTE, data);
 		}
 	}
@@ -111,16 +92,19 @@ namespace detail {
 				command_graph[v].cid = add_info.cid;
 				command_graph[v].nid = add_info.nid;
 				command_graph[v].tid = add_info.tid;
-				command_graph[v].label = add_info.label;
 				command_graph[v].data = add_info.data;
 
 				GRAPH_PROP(command_graph, command_vertices)[add_info.cid] = v;
+				if(add_info.cmd != command::NOP) { GRAPH_PROP(command_graph, task_commands)[add_info.tid].push_back(v); }
 			} break;
 			case graph_op_type::REMOVE_COMMAND: {
 				auto& cmd_vertices = GRAPH_PROP(command_graph, command_vertices);
 				const auto cid = boost::get<remove_command_op>(op.info).cid;
-				boost::clear_vertex(cmd_vertices.at(cid), command_graph);
-				boost::remove_vertex(cmd_vertices.at(cid), command_graph);
+				const auto v = cmd_vertices.at(cid);
+				auto& task_commands = GRAPH_PROP(command_graph, task_commands)[command_graph[v].tid];
+				task_commands.erase(std::remove(task_commands.begin(), task_commands.end(), v), task_commands.end());
+				boost::clear_vertex(v, command_graph);
+				boost::remove_vertex(v, command_graph);
 				cmd_vertices.erase(cid);
 			} break;
 			case graph_op_type::ADD_DEPENDENCY: {
@@ -1,7 +1,8 @@
 #include "graph_generator.h"
 
+#include <algorithm>
+#include <iterator>
 #include <numeric>
-#include <queue>
 
 #include <allscale/utils/string_utils.h>
 
@@ -16,9 +17,8 @@ namespace celerity {
 namespace detail {
 
 	std::pair<cdag_vertex, cdag_vertex> create_task_commands(const task_dag& task_graph, command_dag& command_graph, graph_builder& gb, task_id tid) {
-		const auto begin_task_cmd =
-		    gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, tid, command::NOP, {}, fmt::format("Begin {}", task_graph[tid].label));
-		const auto end_task_cmd = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, tid, command::NOP, {}, fmt::format("End {}", task_graph[tid].label));
+		const auto begin_task_cmd = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, tid, command::NOP, {});
+		const auto end_task_cmd = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, tid, command::NOP, {});
 		gb.commit(); // Commit now so we can get the actual vertices
 
 		const auto begin_task_cmd_v = GRAPH_PROP(command_graph, command_vertices).at(begin_task_cmd);
@@ -33,9 +33,15 @@ namespace detail {
 		return std::make_pair(begin_task_cmd_v, end_task_cmd_v);
 	}
 
-	graph_generator::graph_generator(size_t num_nodes, task_manager& tm, flush_callback flush_callback)
-	    : task_mngr(tm), num_nodes(num_nodes), flush_cb(flush_callback) {
-		register_transformer(std::make_shared<naive_split_transformer>(num_nodes));
+	graph_generator::graph_generator(size_t num_nodes, task_manager& tm, flush_callback flush_callback, std::shared_ptr<graph_transformer> split_transformer,
+	    size_t max_fused_tasks)
+	    : task_mngr(tm), num_nodes(num_nodes), flush_cb(flush_callback), max_fused_tasks(max_fused_tasks) {
+		assert(max_fused_tasks > 0);
+		completed_watermarks = std::make_unique<std::atomic<size_t>[]>(num_nodes);
+		for(size_t i = 0; i < num_nodes; ++i) {
+			completed_watermarks[i] = 0;
+		}
+		register_transformer(split_transformer != nullptr ? split_transformer : std::make_shared<naive_split_transformer>(num_nodes));
 		build_task(tm.get_init_task_id());
 	}
 
@@ -97,58 +103,213 @@ namespace detail {
 		// TODO: At some point we might want to do this also before calling transformers
 		// --> So that more advanced transformations can also take data transfers into account
 		process_task_data_requirements(tid);
+		order_task_commands(tid);
+		if(max_fused_tasks > 1) { try_fuse_task(tid); }
 		task_mngr.mark_task_as_processed(tid);
 	}
 
 	boost::optional<task_id> graph_generator::get_unbuilt_task() const { return graph_utils::get_satisfied_task(*task_mngr.get_task_graph()); }
 
-	void graph_generator::flush(task_id tid) const {
-		const auto& tv = GRAPH_PROP(command_graph, task_vertices).at(tid);
-		std::queue<cdag_vertex> cmd_queue;
-		std::unordered_set<cdag_vertex> queued_cmds;
-		cmd_queue.push(tv.first);
-		queued_cmds.insert(tv.first);
-
-		while(!cmd_queue.empty()) {
-			const cdag_vertex v = cmd_queue.front();
-			cmd_queue.pop();
-			auto& cmd_v = command_graph[v];
-			if(cmd_v.cmd != command::NOP) {
-				const command_pkg pkg{cmd_v.tid, cmd_v.cid, cmd_v.cmd, cmd_v.data};
-				const node_id target = cmd_v.nid;
-
-				// Find all (anti-)dependencies of that command
-				// TODO: We could probably do some pruning here (e.g. omit tasks we know are already finished)
-				std::vector<command_id> dependencies;
-				graph_utils::for_predecessors(command_graph, v, [&dependencies, this](cdag_vertex d, cdag_edge) {
-					if(command_graph[d].cmd != command::NOP) { dependencies.push_back(command_graph[d].cid); }
-				});
-				flush_cb(target, pkg, dependencies);
+	void graph_generator::flush(task_id tid) {
+		if(max_fused_tasks > 1) {
+			// Fused tasks are flushed together with the head of their chain
+			if(held_back_task != boost::none && tid > *held_back_task && tid <= fusion_chain_tail) return;
+			if(held_back_task != boost::none) {
+				flush_commands(*held_back_task);
+				held_back_task = boost::none;
 			}
+			// Hold back compute tasks, so subsequent tasks can be fused into them
+			if(task_mngr.get_task(tid)->get_type() == task_type::COMPUTE) {
+				held_back_task = tid;
+				fusion_chain_tail = tid;
+				if(flush_complete_cb) { flush_complete_cb(); }
+				return;
+			}
+		}
+		flush_commands(tid);
+		if(flush_complete_cb) { flush_complete_cb(); }
+	}
+
+	void graph_generator::set_completed_watermark(node_id nid, command_id watermark) {
+		assert(nid < num_nodes);
+		completed_watermarks[nid].store(watermark, std::memory_order_relaxed);
+	}
+
+	void graph_generator::flush_held_back() {
+		if(held_back_task == boost::none) return;
+		const task_id tid = *held_back_task;
+		held_back_task = boost::none;
+		flush_commands(tid);
+		if(flush_complete_cb) { flush_complete_cb(); }
+	}
 
-			std::vector<cdag_vertex> next_batch;
-			graph_utils::for_successors(command_graph, v, [tid, tv, &queued_cmds, &next_batch, this](cdag_vertex s, cdag_edge) {
-				if(command_graph[s].tid == tid && s != tv.second && queued_cmds.count(s) == 0) { next_batch.push_back(s); }
+	bool graph_generator::try_fuse_task(task_id tid) {
+		if(held_back_task == boost::none || fusion_chain_tail + 1 != tid || tid - *held_back_task + 1 > max_fused_tasks) return false;
+		if(task_mngr.get_task(tid)->get_type() != task_type::COMPUTE) return false;
+
+		const graph_builder gb(command_graph);
+		const auto head_computes = gb.get_commands(*held_back_task, command::COMPUTE);
+		const auto computes = gb.get_commands(tid, command::COMPUTE);
+		if(computes.size() != head_computes.size()) return false;
+
+		// Each COMPUTE command has to be matched with a COMPUTE command of the chain head on the same node and for the same subrange.
+		// Any dependency onto a command within the chain has to be that very command, which in particular rules out all data transfers.
+		std::vector<std::pair<command_id, command_id>> fusions;
+		std::unordered_set<command_id> matched_head_cids;
+		for(const auto cid : computes) {
+			const auto v = GRAPH_PROP(command_graph, command_vertices).at(cid);
+			const auto& cmd_v = command_graph[v];
+			const auto head_it = std::find_if(head_computes.cbegin(), head_computes.cend(), [&](command_id head_cid) {
+				const auto& head_v = command_graph[GRAPH_PROP(command_graph, command_vertices).at(head_cid)];
+				return head_v.nid == cmd_v.nid && head_v.data.compute.subrange == cmd_v.data.compute.subrange && matched_head_cids.count(head_cid) == 0;
+			});
+			if(head_it == head_computes.cend()) return false;
+			const command_id head_cid = *head_it;
+
+			const bool only_external_dependencies = graph_utils::for_predecessors(command_graph, v, [&](cdag_vertex d, cdag_edge) {
+				const auto& dep_v = command_graph[d];
+				if(dep_v.cmd == command::NOP || dep_v.tid < *held_back_task) return true;
+				const auto fused_it = fused_commands.find(dep_v.cid);
+				return (fused_it != fused_commands.end() ? fused_it->second : dep_v.cid) == head_cid;
 			});
+			if(!only_external_dependencies) return false;
 
-			// Make sure to flush PUSH commands first, as we want to execute those before any COMPUTEs, in case they
-			// cannot be performed in parallel (on some platforms parallel copying to host and reading from within kernel
-			// is not supported).
-			std::sort(next_batch.begin(), next_batch.end(),
-			    [this](cdag_vertex a, cdag_vertex b) { return command_graph[a].cmd == command::PUSH && command_graph[b].cmd != command::PUSH; });
+			matched_head_cids.insert(head_cid);
+			fusions.emplace_back(cid, head_cid);
+		}
+
+		for(const auto& f : fusions) {
+			fused_commands[f.first] = f.second;
+			fusion_chains[f.second].push_back(f.first);
+		}
+		fusion_chain_tail = tid;
+		return true;
+	}
 
-			for(auto v : next_batch) {
-				cmd_queue.push(v);
-				queued_cmds.insert(v);
+	void graph_generator::remove_transitive_dependencies(std::vector<cdag_vertex>& dependencies, command_id completed_watermark) const {
+		std::unordered_set<cdag_vertex> implied;
+		std::vector<task_id> searched_tasks;
+		std::vector<cdag_vertex> task_dependencies;
+		for(const auto d : dependencies) {
+			const task_id tid = command_graph[d].tid;
+			if(std::find(searched_tasks.cbegin(), searched_tasks.cend(), tid) != searched_tasks.cend()) continue;
+			searched_tasks.push_back(tid);
+			task_dependencies.clear();
+			std::copy_if(dependencies.cbegin(), dependencies.cend(), std::back_inserter(task_dependencies),
+			    [tid, this](cdag_vertex other) { return command_graph[other].tid == tid; });
+			if(task_dependencies.size() < 2) continue;
+
+			// We only consider paths within the same task. NOPs are never flushed, so we can't rely on paths through them.
+			// Commands below the completed watermark (and thus all of their predecessors) have already been completed, so we don't have to
+			// search any further. At worst, we keep a dependency that would have been implied.
+			const auto found = graph_utils::find_implied_vertices(command_graph, task_dependencies, [tid, completed_watermark, this](cdag_vertex p) {
+				return command_graph[p].tid == tid && command_graph[p].cmd != command::NOP && command_graph[p].cid >= completed_watermark;
+			});
+			implied.insert(found.cbegin(), found.cend());
+		}
+		if(implied.empty()) return;
+		dependencies.erase(std::remove_if(dependencies.begin(), dependencies.end(), [&implied](cdag_vertex d) { return implied.count(d) != 0; }),
+		    dependencies.end());
+	}
+
+	void graph_generator::order_task_commands(task_id tid) {
+		const auto it = GRAPH_PROP(command_graph, task_commands).find(tid);
+		if(it == GRAPH_PROP(command_graph, task_commands).end()) return;
+		auto& commands = it->second;
+
+		// Commands have to be flushed after all of their dependencies within the same task, as the executor assumes
+		// that unknown dependencies have already been completed. We therefore order them in waves, each consisting of the commands
+		// whose dependencies within the task are all part of previous waves.
+		std::unordered_map<cdag_vertex, size_t> unsatisfied_dependencies;
+		std::vector<cdag_vertex> wave;
+		for(const auto v : commands) {
+			size_t count = 0;
+			graph_utils::for_predecessors(command_graph, v, [tid, &count, this](cdag_vertex p, cdag_edge) {
+				if(command_graph[p].tid == tid && command_graph[p].cmd != command::NOP) { count++; }
+			});
+			if(count == 0) {
+				wave.push_back(v);
+			} else {
+				unsatisfied_dependencies[v] = count;
 			}
 		}
+
+		// Within each wave, make sure to flush PUSH commands first, as we want to execute those before any COMPUTEs, in case they
+		// cannot be performed in parallel (on some platforms parallel copying to host and reading from within kernel
+		// is not supported).
+		// Next we flush COMPUTEs that are ready at this point, before any AWAIT_PUSHes. This allows the executor to start computing
+		// chunks that don't require any remote data while incoming transfers for other chunks are still in flight.
+		const auto flush_rank = [this](cdag_vertex v) {
+			switch(command_graph[v].cmd) {
+			case command::PUSH: return 0;
+			case command::COMPUTE: return 1;
+			default: return 2;
+			}
+		};
+
+		std::vector<cdag_vertex> ordered;
+		ordered.reserve(commands.size());
+		std::vector<cdag_vertex> next_wave;
+		while(!wave.empty()) {
+			std::stable_sort(wave.begin(), wave.end(), [&flush_rank](cdag_vertex a, cdag_vertex b) { return flush_rank(a) < flush_rank(b); });
+			ordered.insert(ordered.end(), wave.cbegin(), wave.cend());
+			for(const auto v : wave) {
+				graph_utils::for_successors(command_graph, v, [&unsatisfied_dependencies, &next_wave](cdag_vertex s, cdag_edge) {
+					const auto dep_it = unsatisfied_dependencies.find(s);
+					if(dep_it != unsatisfied_dependencies.end() && --dep_it->second == 0) { next_wave.push_back(s); }
+				});
+			}
+			wave.clear();
+			std::swap(wave, next_wave);
+		}
+
+		assert(ordered.size() == commands.size());
+		commands = std::move(ordered);
 	}
 
-	void graph_generator::print_graph(logger& graph_logger) {
-		if(command_graph.m_vertices.size() < 200) {
-			graph_utils::print_graph(command_graph, graph_logger);
-		} else {
-			graph_logger.warn("Command graph is very large ({} vertices). Skipping GraphViz output", command_graph.m_vertices.size());
+	void graph_generator::flush_commands(task_id tid) const {
+		const auto it = GRAPH_PROP(command_graph, task_commands).find(tid);
+		if(it == GRAPH_PROP(command_graph, task_commands).end()) return;
+
+		for(const auto v : it->second) {
+			auto& cmd_v = command_graph[v];
+			command_pkg pkg{cmd_v.tid, cmd_v.cid, cmd_v.cmd, cmd_v.data};
+			const node_id target = cmd_v.nid;
+
+			// Find all (anti-)dependencies of that command, as well as those of any commands fused into it
+			std::vector<cdag_vertex> dependency_vertices;
+			const auto add_dependencies = [&dependency_vertices, this](cdag_vertex cmd) {
+				graph_utils::for_predecessors(command_graph, cmd, [&dependency_vertices, this](cdag_vertex d, cdag_edge) {
+					if(command_graph[d].cmd == command::NOP) return;
+					if(std::find(dependency_vertices.cbegin(), dependency_vertices.cend(), d) == dependency_vertices.cend()) {
+						dependency_vertices.push_back(d);
+					}
+				});
+			};
+			add_dependencies(v);
+
+			const auto chain_it = fusion_chains.find(cmd_v.cid);
+			if(chain_it != fusion_chains.end()) {
+				pkg.data.compute.fused_tasks = chain_it->second.size();
+				for(const auto fused_cid : chain_it->second) {
+					add_dependencies(GRAPH_PROP(command_graph, command_vertices).at(fused_cid));
+				}
+			}
+
+			// Dependencies onto commands that are known to have completed can be omitted altogether
+			const command_id completed_watermark = completed_watermarks[target].load(std::memory_order_relaxed);
+			remove_transitive_dependencies(dependency_vertices, completed_watermark);
+
+			std::vector<command_id> dependencies;
+			for(const auto d : dependency_vertices) {
+				// Dependencies onto fused commands have to be redirected to the command that actually executes them
+				const auto fused_it = fused_commands.find(command_graph[d].cid);
+				const command_id dep_cid = fused_it != fused_commands.end() ? fused_it->second : command_graph[d].cid;
+				if(dep_cid == pkg.cid || dep_cid < completed_watermark) continue;
+				if(std::find(dependencies.cbegin(), dependencies.cend(), dep_cid) == dependencies.cend()) { dependencies.push_back(dep_cid); }
+			}
+
+			flush_cb(target, pkg, dependencies);
 		}
 	}
 
@@ -180,6 +341,43 @@ namespace detail {
 		return result;
 	}
 
+	void graph_generator::print_graph(logger& graph_logger) {
+		if(command_graph.m_vertices.size() >= 200) {
+			graph_logger.warn("Command graph is very large ({} vertices). Skipping GraphViz output", command_graph.m_vertices.size());
+			return;
+		}
+
+		const auto get_label = [this](cdag_vertex v) {
+			const auto& cmd_v = command_graph[v];
+			const auto tsk = task_mngr.get_task(cmd_v.tid);
+			if(cmd_v.cmd == command::NOP) {
+				const bool is_begin = GRAPH_PROP(command_graph, task_vertices).at(cmd_v.tid).first == v;
+				return fmt::format("[{}] {} {}", cmd_v.cid, is_begin ? "Begin" : "End", graph_utils::get_task_label(cmd_v.tid, tsk.get()));
+			}
+
+			// Add access modes and ranges of execution commands for debugging
+			std::string label = graph_utils::get_command_label(cmd_v);
+			buffer_requirements_map requirements;
+			if(cmd_v.cmd == command::COMPUTE) {
+				requirements = get_buffer_requirements(dynamic_cast<const compute_task*>(tsk.get()), cmd_v.data.compute.subrange);
+			} else if(cmd_v.cmd == command::MASTER_ACCESS) {
+				requirements = get_buffer_requirements(dynamic_cast<const master_access_task*>(tsk.get()));
+			}
+			for(const auto& it : requirements) {
+				for(const auto mode : access::detail::all_modes) {
+					if(it.second.count(mode) == 0 || it.second.at(mode).empty()) continue;
+					label += fmt::format("\\n{} {} {}", access::detail::mode_traits::name(mode), it.first, toString(it.second.at(mode)));
+				}
+			}
+
+			const auto fused_it = fused_commands.find(cmd_v.cid);
+			if(fused_it != fused_commands.end()) { label += fmt::format("\\nfused into {}", fused_it->second); }
+			return label;
+		};
+
+		graph_utils::print_graph(command_graph, get_label, graph_logger);
+	}
+
 	void graph_generator::generate_anti_dependencies(task_id tid, buffer_id bid, const region_map<boost::optional<command_id>>& last_writers_map,
 	    const GridRegion<3>& write_req, command_id write_cid, graph_builder& gb) {
 		const auto last_writers = last_writers_map.get_region_values(write_req);
@@ -230,6 +428,17 @@ namespace detail {
 	void graph_generator::process_task_data_requirements(task_id tid) {
 		buffer_state_map final_buffer_states = buffer_states;
 
+		// Data that is pulled in for one command is also available to all other commands of this task on the same node (e.g. when
+		// splitting into multiple chunks per node), so we keep a separate working copy of the buffer states for each node.
+		// Importantly, these do NOT contain the NEW buffer states produced by this task.
+		std::unordered_map<node_id, buffer_state_map> node_working_buffer_states;
+
+		// Likewise, we have to make sure to update the last writer map for a node and buffer only after all new writes of this task have been
+		// processed, as we otherwise risk creating anti dependencies onto commands within the same task, that shouldn't exist.
+		// (For example, an AWAIT_PUSH could be falsely identified as an anti-dependency for a "read_write" COMPUTE, or one chunk's COMPUTE
+		// for another chunk on the same node).
+		std::unordered_map<node_id, buffer_writer_map> node_working_buffer_last_writers;
+
 		graph_builder gb(command_graph);
 		auto tsk = task_mngr.get_task(tid);
 		graph_utils::for_successors(command_graph, GRAPH_PROP(command_graph, task_vertices)[tid].first, [&](cdag_vertex v, cdag_edge) {
@@ -253,13 +462,13 @@ namespace detail {
 
 				// We keep a working copy around that is updated for data that is pulled in for the different access modes.
 				// This is useful so we don't generate multiple PULLs for the same buffer ranges.
-				// Importantly, this does NOT contain the NEW buffer states produced by this task.
-				auto working_buffer_state = buffer_states.at(bid);
+				auto& node_working_states = node_working_buffer_states[nid];
+				if(node_working_states.count(bid) == 0) { node_working_states.emplace(bid, buffer_states.at(bid)); }
+				auto& working_buffer_state = node_working_states.at(bid);
 
-				// Likewise, we have to make sure to update the last writer map for this node and buffer only after all new writes have been processed,
-				// as we otherwise risk creating anti dependencies onto commands within the same task, that shouldn't exist.
-				// (For example, an AWAIT_PUSH could be falsely identified as an anti-dependency for a "read_write" COMPUTE).
-				auto working_node_buffer_last_writer = node_buffer_last_writer.at(nid).at(bid);
+				auto& node_working_last_writers = node_working_buffer_last_writers[nid];
+				if(node_working_last_writers.count(bid) == 0) { node_working_last_writers.emplace(bid, node_buffer_last_writer.at(nid).at(bid)); }
+				auto& working_node_buffer_last_writer = node_working_last_writers.at(bid);
 
 				const auto& initial_node_buffer_last_writer = node_buffer_last_writer.at(nid).at(bid);
 
@@ -271,9 +480,6 @@ namespace detail {
 						continue;
 					}
 
-					// Add access mode and range to execution command node label for debugging
-					command_graph[v].label = fmt::format("{}\\n{} {} {}", command_graph[v].label, access::detail::mode_traits::name(mode), bid, toString(req));
-
 					if(access::detail::mode_traits::is_consumer(mode)) {
 						// Store the read access for determining anti-dependencies later on
 						task_buffer_reads[tid][bid].emplace_back(std::make_pair(cid, req));
@@ -350,11 +556,15 @@ namespace detail {
 						final_buffer_states.at(bid).update_region(req, {{nid, cid}});
 					}
 				}
-
-				node_buffer_last_writer.at(nid).at(bid).merge(working_node_buffer_last_writer);
 			}
 		});
 
+		for(auto& nid_and_writers : node_working_buffer_last_writers) {
+			for(auto& bid_and_writers : nid_and_writers.second) {
+				node_buffer_last_writer.at(nid_and_writers.first).at(bid_and_writers.first).merge(bid_and_writers.second);
+			}
+		}
+
 		gb.commit();
 
 		// As the last step, we determine potential "intra-task" race conditions.
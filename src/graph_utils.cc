@@ -4,6 +4,7 @@
 
 #include "command.h"
 #include "grid.h"
+#include "task.h"
 
 namespace celerity {
 namespace detail {
@@ -29,7 +30,10 @@ namespace detail {
 		// --------------------------- Graph printing ---------------------------
 
 
-		void print_graph(const task_dag& tdag, logger& graph_logger) {
+		void print_graph(const task_dag& tdag, const std::function<std::string(task_id)>& get_label, logger& graph_logger) {
+			const auto vertex_props_writer = [&](std::ostream& out, auto v) {
+				out << "[label=" << boost::escape_dot_string(get_label(static_cast<task_id>(v))) << "]";
+			};
 			const auto edge_props_writer = [&](std::ostream& out, auto e) {
 				if(tdag[e].anti_dependency) { out << "[color=limegreen]"; }
 			};
@@ -38,16 +42,24 @@ namespace detail {
 				bool operator()(const tdag_vertex& v) const { return static_cast<task_id>(v) != 0; };
 			};
 			const boost::filtered_graph<task_dag, boost::keep_all, init_task_filter> without_init(tdag, boost::keep_all(), init_task_filter{});
-			write_graph(without_init, "TaskGraph", boost::make_label_writer(boost::get(&tdag_vertex_properties::label, tdag)), edge_props_writer, graph_logger);
+			write_graph(without_init, "TaskGraph", vertex_props_writer, edge_props_writer, graph_logger);
+		}
+
+		std::string get_task_label(task_id tid, const task* tsk) {
+			if(tsk == nullptr) { return fmt::format("Task {} <INIT>", static_cast<size_t>(tid)); }
+			switch(tsk->get_type()) {
+			case task_type::COMPUTE: return fmt::format("Task {} ({})", static_cast<size_t>(tid), dynamic_cast<const compute_task*>(tsk)->get_debug_name());
+			case task_type::MASTER_ACCESS: return fmt::format("Task {} (master-access)", static_cast<size_t>(tid));
+			default: return fmt::format("Task {}", static_cast<size_t>(tid));
+			}
 		}
 
 		std::string get_command_label(const cdag_vertex_properties& props) {
-			if(props.cmd == command::NOP) { return fmt::format("[{}] {}", props.cid, props.label); }
 			const std::string label = fmt::format("[{}] Node {}:\\n", props.cid, props.nid);
 
 			switch(props.cmd) {
-			case command::COMPUTE: return label + fmt::format("COMPUTE {}", detail::subrange_to_grid_region(props.data.compute.subrange)) + props.label;
-			case command::MASTER_ACCESS: return label + "MASTER ACCESS" + props.label;
+			case command::COMPUTE: return label + fmt::format("COMPUTE {}", detail::subrange_to_grid_region(props.data.compute.subrange));
+			case command::MASTER_ACCESS: return label + "MASTER ACCESS";
 			case command::PUSH:
 				return label
 				       + fmt::format(
@@ -56,11 +68,11 @@ namespace detail {
 				return label
 				       + fmt::format("AWAIT PUSH {} from {}\\n {}", props.data.await_push.bid, props.data.await_push.source,
 				             detail::subrange_to_grid_region(props.data.await_push.subrange));
-			default: return props.label;
+			default: return fmt::format("[{}]", props.cid);
 			}
 		}
 
-		void print_graph(command_dag& cdag, logger& graph_logger) {
+		void print_graph(command_dag& cdag, const std::function<std::string(cdag_vertex)>& get_label, logger& graph_logger) {
 			// Boost's write_graphviz wants vertices with the vertex_index_t property.
 			// Since we're not storing vertices in a vector (boost::vecS), we unfortunately have to populate the index ourselves.
 			int idx = 0;
@@ -71,7 +83,7 @@ namespace detail {
 				const char* colors[] = {"black", "crimson", "dodgerblue4", "goldenrod", "maroon4", "springgreen2", "tan1", "chartreuse2"};
 
 				std::unordered_map<std::string, std::string> props;
-				props["label"] = boost::escape_dot_string(get_command_label(cdag[v]));
+				props["label"] = boost::escape_dot_string(get_label(v));
 
 				props["fontcolor"] = colors[cdag[v].nid % (sizeof(colors) / sizeof(char*))];
 
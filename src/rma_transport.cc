@@ -0,0 +1,195 @@
+#include "rma_transport.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace celerity {
+namespace detail {
+
+	constexpr size_t rma_transport::entry_header_size;
+	constexpr size_t rma_transport::alignment;
+
+	namespace {
+		enum entry_state : uint64_t { EMPTY = 0, READY = 1, SKIPPED = 2 };
+
+		// Origin buffers for state updates. These are never modified, so they can be used for any number of concurrent operations.
+		const uint64_t empty_state = EMPTY;
+		const uint64_t ready_state = READY;
+		const uint64_t skipped_state = SKIPPED;
+	} // namespace
+
+	rma_transport::rma_transport(size_t region_size) : region_size(region_size / alignment * alignment) {
+		int world_size;
+		MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+		num_nodes = static_cast<size_t>(world_size);
+		int world_rank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+		local_nid = static_cast<node_id>(world_rank);
+		produced_bytes.resize(num_nodes, 0);
+		consumed_bytes.resize(num_nodes, 0);
+		unpublished.resize(num_nodes);
+		publish_counts.resize(num_nodes, 0);
+
+		const size_t window_size = num_nodes * sizeof(uint64_t) + num_nodes * this->region_size;
+		MPI_Win_allocate(static_cast<MPI_Aint>(window_size), 1, MPI_INFO_NULL, MPI_COMM_WORLD, &window_base, &window);
+		// All entries start out empty, and no node may write into our window before that is the case
+		std::memset(window_base, 0, window_size);
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+
+	rma_transport::~rma_transport() {
+		MPI_Win_unlock_all(window);
+		MPI_Win_free(&window);
+	}
+
+	uint64_t rma_transport::get_reported_consumed_bytes(node_id target) const {
+		uint64_t value;
+		std::memcpy(&value, window_base + target * sizeof(uint64_t), sizeof(uint64_t));
+		return value;
+	}
+
+	rma_transport::entry rma_transport::allocate(node_id target, size_t message_size) {
+		assert(can_transfer(message_size));
+		entry e;
+		e.target = target;
+		e.message_size = message_size;
+
+		const size_t entry_size = get_entry_size(message_size);
+		MPI_Win_sync(window);
+		const uint64_t consumed = get_reported_consumed_bytes(target);
+		uint64_t& produced = produced_bytes[target];
+
+		// Entries are never split across the end of the ring. If the remaining space is too small, it is skipped.
+		const size_t position = produced % region_size;
+		const size_t skipped = position + entry_size > region_size ? region_size - position : 0;
+		// The ring must never become completely full, so there always is a free slot following the newest entry (see ::poll())
+		if(produced + skipped + entry_size - consumed >= region_size) return e;
+
+		const MPI_Aint region = get_region_displacement(local_nid);
+		if(skipped > 0) {
+			e.skipped_displacement = region + static_cast<MPI_Aint>(position);
+			produced += skipped;
+		}
+		e.displacement = region + static_cast<MPI_Aint>(produced % region_size);
+		produced += entry_size;
+		e.next_displacement = region + static_cast<MPI_Aint>(produced % region_size);
+		unpublished[target].push_back(unpublished_entry{e, false});
+		return e;
+	}
+
+	void rma_transport::put(const entry& e, const void* message, MPI_Request* request) {
+		assert(e.is_valid());
+		MPI_Rput(message, static_cast<int>(e.message_size), MPI_BYTE, static_cast<int>(e.target), e.displacement + static_cast<MPI_Aint>(entry_header_size),
+		    static_cast<int>(e.message_size), MPI_BYTE, window, request);
+	}
+
+	void rma_transport::publish(const entry& e) {
+		assert(e.is_valid());
+		auto& queue = unpublished[e.target];
+		const auto it = std::find_if(queue.begin(), queue.end(), [&e](const unpublished_entry& u) { return u.e.displacement == e.displacement; });
+		assert(it != queue.end() && !it->written);
+		it->written = true;
+	}
+
+	bool rma_transport::poll(const std::function<void(const char* message)>& consume) {
+		bool progress = publish_written_entries();
+
+		MPI_Win_sync(window);
+		for(node_id source = 0; source < num_nodes; ++source) {
+			char* region = window_base + get_region_displacement(source);
+			bool consumed_any = false;
+			while(true) {
+				const size_t position = consumed_bytes[source] % region_size;
+				char* e = region + position;
+				uint64_t state;
+				std::memcpy(&state, e, sizeof(uint64_t));
+				if(state == EMPTY) break;
+
+				if(state == READY) {
+					uint64_t message_size;
+					std::memcpy(&message_size, e + sizeof(uint64_t), sizeof(uint64_t));
+					consume(e + entry_header_size);
+					consumed_bytes[source] += get_entry_size(message_size);
+				} else {
+					assert(state == SKIPPED);
+					consumed_bytes[source] += region_size - position;
+				}
+				consumed_any = true;
+			}
+			if(!consumed_any) continue;
+
+			// Let the source know it can reuse the space. Instead of flushing right away, this becomes visible with the first flush of the next call.
+			MPI_Put(&consumed_bytes[source], 1, MPI_UINT64_T, static_cast<int>(source), static_cast<MPI_Aint>(local_nid * sizeof(uint64_t)), 1, MPI_UINT64_T,
+			    window);
+			if(std::find(flush_targets.cbegin(), flush_targets.cend(), source) == flush_targets.cend()) { flush_targets.push_back(source); }
+			progress = true;
+		}
+		return progress;
+	}
+
+	bool rma_transport::publish_written_entries() {
+		// Publishing clears the entry following each published one, so entries have to be published in allocation order.
+		// If that one had already been published, the receiver would never see it.
+		size_t publish_total = 0;
+		for(node_id target = 0; target < num_nodes; ++target) {
+			const auto& queue = unpublished[target];
+			size_t count = 0;
+			while(count < queue.size() && queue[count].written) {
+				++count;
+			}
+			publish_counts[target] = count;
+			publish_total += count;
+		}
+
+		// Entries are published in two steps, each followed by a single flush per target. First, their headers are written with an empty state.
+		// The receiver finds the next entry right where the previous one ends, or at the start of the ring if it was preceded by skipped space.
+		// Both locations might still contain stale data from earlier messages, so we have to clear them before setting any flags.
+		header_buffers.resize(2 * publish_total);
+		size_t next_header = 0;
+		for(node_id target = 0; target < num_nodes; ++target) {
+			const size_t count = publish_counts[target];
+			if(count == 0) continue;
+			const auto& queue = unpublished[target];
+			for(size_t i = 0; i < count; ++i) {
+				const entry& e = queue[i].e;
+				uint64_t* header = &header_buffers[next_header];
+				next_header += 2;
+				header[0] = EMPTY;
+				header[1] = e.message_size;
+				MPI_Put(header, 2, MPI_UINT64_T, static_cast<int>(target), e.displacement, 2, MPI_UINT64_T, window);
+				// If the following entry is published as well, its header is written right there anyway
+				const bool next_published = i + 1 < count && queue[i + 1].e.displacement == e.next_displacement;
+				if(!next_published) { MPI_Put(&empty_state, 1, MPI_UINT64_T, static_cast<int>(target), e.next_displacement, 1, MPI_UINT64_T, window); }
+			}
+			if(std::find(flush_targets.cbegin(), flush_targets.cend(), target) == flush_targets.cend()) { flush_targets.push_back(target); }
+		}
+		// The messages have only been completed locally so far. Make sure they have arrived before setting the flags.
+		// This also makes the consumed bytes reported by the previous call visible.
+		for(const auto target : flush_targets) {
+			MPI_Win_flush(static_cast<int>(target), window);
+		}
+		flush_targets.clear();
+		if(publish_total == 0) return false;
+
+		for(node_id target = 0; target < num_nodes; ++target) {
+			const size_t count = publish_counts[target];
+			if(count == 0) continue;
+			auto& queue = unpublished[target];
+			for(size_t i = 0; i < count; ++i) {
+				const entry& e = queue.front().e;
+				MPI_Put(&ready_state, 1, MPI_UINT64_T, static_cast<int>(target), e.displacement, 1, MPI_UINT64_T, window);
+				if(e.skipped_displacement >= 0) {
+					MPI_Put(&skipped_state, 1, MPI_UINT64_T, static_cast<int>(target), e.skipped_displacement, 1, MPI_UINT64_T, window);
+				}
+				queue.pop_front();
+			}
+			// There's no telling when the flags would become visible otherwise
+			MPI_Win_flush(static_cast<int>(target), window);
+		}
+		return true;
+	}
+
+} // namespace detail
+} // namespace celerity
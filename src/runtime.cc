@@ -1,5 +1,7 @@
 #include "runtime.h"
 
+#include <algorithm>
+#include <functional>
 #include <queue>
 #include <sstream>
 #include <string>
@@ -21,9 +23,10 @@
 #include "graph_generator.h"
 #include "graph_utils.h"
 #include "logger.h"
-#include "mpi_support.h"
 #include "scheduler.h"
 #include "task_manager.h"
+#include "transformers/load_balancing_split.h"
+#include "transformers/naive_split.h"
 #include "user_bench.h"
 
 namespace celerity {
@@ -82,12 +85,9 @@ namespace detail {
 			assert(provided == MPI_THREAD_MULTIPLE);
 		}
 
-		int world_size;
-		MPI_Comm_size(MPI_COMM_WORLD, &world_size);
-		num_nodes = world_size;
-
-		int world_rank;
-		MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+		cmd_transport = std::make_unique<mpi_transport>();
+		num_nodes = cmd_transport->get_num_nodes();
+		const auto world_rank = cmd_transport->get_local_nid();
 		is_master = world_rank == 0;
 
 		default_logger = logger("default").create_context({{"rank", std::to_string(world_rank)}});
@@ -96,17 +96,68 @@ namespace detail {
 		cfg = std::make_unique<config>(argc, argv, *default_logger);
 		graph_logger->set_level(cfg->get_log_level());
 
-		experimental::bench::detail::user_benchmarker::initialize(*cfg, static_cast<node_id>(world_rank));
+		experimental::bench::detail::user_benchmarker::initialize(*cfg, world_rank);
 
 		queue = std::make_unique<device_queue>(*default_logger);
 
 		// Initialize worker classes (but don't start them up yet)
 		task_mngr = std::make_shared<task_manager>(is_master);
-		exec = std::make_unique<executor>(*queue, *task_mngr, default_logger);
+		auto split_weights_cfg = cfg->get_split_weights();
+		if(split_weights_cfg != boost::none && split_weights_cfg->size() != num_nodes) {
+			default_logger->warn("CELERITY_SPLIT_WEIGHTS contains {} value(s), but there are {} nodes - will be ignored", split_weights_cfg->size(), num_nodes);
+			split_weights_cfg = boost::none;
+		}
+		const bool pinned_split_weights = split_weights_cfg != boost::none;
+		const bool measure_throughput = !pinned_split_weights && cfg->get_enable_load_balancing() != boost::none && *cfg->get_enable_load_balancing();
+		const auto shm_segment_size_cfg = cfg->get_shm_segment_size();
+		auto btm = std::make_unique<buffer_transfer_manager>(default_logger,
+		    shm_segment_size_cfg != boost::none ? *shm_segment_size_cfg : buffer_transfer_manager::default_shm_segment_size,
+		    cfg->get_enable_rma_transfers() != boost::none && *cfg->get_enable_rma_transfers());
+		const auto max_compute_jobs_cfg = cfg->get_max_compute_jobs();
+		exec = std::make_unique<executor>(*queue, *task_mngr, default_logger, std::make_unique<mpi_transport>(), std::move(btm), measure_throughput,
+		    max_compute_jobs_cfg != boost::none ? *max_compute_jobs_cfg : admission_control::default_max_running_compute_jobs);
+		// Commands for the master node are passed to its executor directly
+		if(is_master) { exec->enable_local_commands(); }
 		if(is_master) {
-			ggen = std::make_shared<graph_generator>(num_nodes, *task_mngr,
-			    [this](node_id target, const command_pkg& pkg, const std::vector<command_id>& dependencies) { flush_command(target, pkg, dependencies); });
+			const auto chunks_per_node_cfg = cfg->get_chunks_per_node();
+			const size_t chunks_per_node = chunks_per_node_cfg != boost::none ? *chunks_per_node_cfg : 1;
+			const auto master_participation_cfg = cfg->get_master_participation();
+			const double master_weight = master_participation_cfg != boost::none ? master_participation_cfg->weight : 1.0;
+			const auto forced_wg_size_cfg = cfg->get_forced_work_group_size();
+			const size_t forced_work_group_size = forced_wg_size_cfg != boost::none ? *forced_wg_size_cfg : 0;
+			std::shared_ptr<graph_transformer> split_transformer;
+			std::function<void(double)> set_master_weight;
+			if(pinned_split_weights || measure_throughput) {
+				const auto damping_cfg = cfg->get_load_balancing_damping();
+				const auto lb_split = std::make_shared<load_balancing_split_transformer>(num_nodes,
+				    damping_cfg != boost::none ? *damping_cfg : load_balancing_split_transformer::default_damping,
+				    pinned_split_weights ? *split_weights_cfg : std::vector<double>{}, chunks_per_node, forced_work_group_size);
+				if(measure_throughput) {
+					exec->set_throughput_callback([lb_split](node_id nid, size_t work_items, std::chrono::microseconds duration) {
+						lb_split->report_throughput(nid, work_items, duration);
+					});
+				}
+				lb_split->set_master_weight(master_weight);
+				set_master_weight = [lb_split](double weight) { lb_split->set_master_weight(weight); };
+				split_transformer = lb_split;
+			} else {
+				const auto naive_split = std::make_shared<naive_split_transformer>(num_nodes, chunks_per_node, master_weight, forced_work_group_size);
+				set_master_weight = [naive_split](double weight) { naive_split->set_master_weight(weight); };
+				split_transformer = naive_split;
+			}
+			const auto max_fused_tasks_cfg = cfg->get_max_fused_tasks();
+			ggen = std::make_shared<graph_generator>(
+			    num_nodes, *task_mngr,
+			    [this](node_id target, const command_pkg& pkg, const std::vector<command_id>& dependencies) { flush_command(target, pkg, dependencies); },
+			    split_transformer, max_fused_tasks_cfg != boost::none ? *max_fused_tasks_cfg : 1);
+			pending_batches.resize(num_nodes);
+			exec->set_completion_callback([ggen = ggen](node_id nid, command_id watermark) { ggen->set_completed_watermark(nid, watermark); });
+			ggen->set_flush_complete_callback([this]() { send_pending_batches(); });
 			schdlr = std::make_unique<scheduler>(ggen);
+			if(master_participation_cfg != boost::none && master_participation_cfg->automatic) {
+				// The busier the scheduler, the less work we assign to the master node
+				schdlr->set_utilization_callback([set_master_weight](double utilization) { set_master_weight(1.0 - std::min(utilization, 1.0)); });
+			}
 			task_mngr->register_task_callback([this]() { schdlr->notify_task_created(); });
 		}
 
@@ -130,8 +181,8 @@ namespace detail {
 		// All buffers should have unregistered themselves by now.
 		assert(buffer_ptrs.empty());
 
-		// Make sure we free all of our MPI custom types before we finalize
-		active_flushes.clear();
+		// Release the buffers of all command messages before we finalize
+		cmd_transport.reset();
 		if(!test_mode) { MPI_Finalize(); }
 	}
 
@@ -155,6 +206,7 @@ namespace detail {
 				command_pkg pkg{0, base_cmd_id + n, command::SHUTDOWN, command_data{}};
 				flush_command(n, pkg, {});
 			}
+			send_pending_batches();
 		}
 
 		exec->shutdown();
@@ -205,19 +257,23 @@ namespace detail {
 	}
 
 	void runtime::flush_command(node_id target, const command_pkg& pkg, const std::vector<command_id>& dependencies) {
-		// Even though command packages are small enough to use a blocking send we want to be able to send to the master node as well,
-		// which is why we have to use Isend after all. We also have to make sure that the buffer stays around until the send is complete.
-		active_flushes.push_back(flush_handle{pkg, dependencies, MPI_REQUEST_NULL, {}});
-		auto it = active_flushes.rbegin();
-		it->data_type = mpi_support::build_single_use_composite_type(
-		    {{sizeof(command_pkg), &it->pkg}, {sizeof(command_id) * dependencies.size(), it->dependencies.data()}});
-		MPI_Isend(MPI_BOTTOM, 1, *it->data_type, static_cast<int>(target), mpi_support::TAG_CMD, MPI_COMM_WORLD, &active_flushes.rbegin()->req);
-
-		// Cleanup finished transfers.
-		// Just check the oldest flush. Since commands are small this will stay in equilibrium fairly quickly.
-		int done;
-		MPI_Test(&active_flushes.begin()->req, &done, MPI_STATUS_IGNORE);
-		if(done) { active_flushes.pop_front(); }
+		if(target == 0) {
+			// We're on the master node, so there's no need to go through the transport
+			exec->enqueue_local_command(pkg, dependencies);
+			return;
+		}
+		pending_batches[target].add(pkg, dependencies);
+	}
+
+	void runtime::send_pending_batches() {
+		exec->end_local_flush();
+		for(node_id target = 0; target < pending_batches.size(); ++target) {
+			if(pending_batches[target].empty()) continue;
+			cmd_transport->send(target, transport::channel::COMMANDS, pending_batches[target].take_data());
+		}
+
+		// Hand the buffers of all finished sends back so their capacity can be reused for subsequent batches
+		cmd_transport->poll_sends([this](node_id target, std::vector<unsigned char> data) { pending_batches[target].recycle(std::move(data)); });
 	}
 
 } // namespace detail
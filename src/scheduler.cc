@@ -5,6 +5,8 @@
 namespace celerity {
 namespace detail {
 
+	constexpr std::chrono::milliseconds scheduler::utilization_window;
+
 	scheduler::scheduler(std::shared_ptr<graph_generator> ggen) : ggen(ggen) {}
 
 	void scheduler::startup() { schd_thrd = std::thread(&scheduler::schedule, this); }
@@ -27,16 +29,38 @@ namespace detail {
 	void scheduler::schedule() {
 		std::unique_lock<std::mutex> lk(tasks_available_mutex);
 
+		using clock = std::chrono::steady_clock;
+		auto window_start = clock::now();
+		clock::duration busy_time{};
+
 		while(true) {
 			// TODO: We currently operate in lockstep with the main thread. This is less than ideal.
 			tasks_available_cv.wait(lk, [this] { return unscheduled_tasks > 0; });
-			if(should_shutdown && unscheduled_tasks == 1) return;
+			const auto busy_start = clock::now();
+			if(should_shutdown && unscheduled_tasks == 1) {
+				ggen->flush_held_back();
+				return;
+			}
 
 			const auto tid = ggen->get_unbuilt_task();
 			assert(tid != boost::none);
 			ggen->build_task(*tid);
 			ggen->flush(*tid);
 			unscheduled_tasks--;
+
+			// The graph generator may hold back commands in order to fuse them with subsequent tasks.
+			// We only allow this while more tasks are already waiting, so we never delay execution to wait for new tasks.
+			if(unscheduled_tasks == 0) { ggen->flush_held_back(); }
+
+			if(utilization_cb) {
+				const auto now = clock::now();
+				busy_time += now - busy_start;
+				if(now - window_start >= utilization_window) {
+					utilization_cb(std::chrono::duration<double>(busy_time) / std::chrono::duration<double>(now - window_start));
+					window_start = now;
+					busy_time = {};
+				}
+			}
 		}
 	}
 
@@ -0,0 +1,131 @@
+#include "shared_memory_transport.h"
+
+#include <cassert>
+#include <vector>
+
+namespace celerity {
+namespace detail {
+
+	constexpr size_t shared_memory_transport::no_space;
+	constexpr size_t shared_memory_transport::alignment;
+
+	shared_memory_transport::shared_memory_transport(size_t segment_size) {
+		int world_rank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+		local_nid = static_cast<node_id>(world_rank);
+
+		MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &host_comm);
+		int host_size;
+		MPI_Comm_size(host_comm, &host_size);
+		// There is nobody to share memory with
+		if(host_size == 1) return;
+
+		std::vector<int> world_ranks(host_size);
+		MPI_Allgather(&world_rank, 1, MPI_INT, world_ranks.data(), 1, MPI_INT, host_comm);
+
+		// Allow each segment to be placed in memory close to the process owning it
+		MPI_Info info;
+		MPI_Info_create(&info);
+		MPI_Info_set(info, "alloc_shared_noncontig", "true");
+		MPI_Win_allocate_shared(static_cast<MPI_Aint>(segment_size), 1, info, host_comm, &local_segment, &window);
+		MPI_Info_free(&info);
+
+		for(int i = 0; i < host_size; ++i) {
+			MPI_Aint size;
+			int disp_unit;
+			char* segment;
+			MPI_Win_shared_query(window, i, &size, &disp_unit, &segment);
+			peers[static_cast<node_id>(world_ranks[i])] = peer{segment, static_cast<size_t>(size)};
+		}
+		// The MPI implementation might round up the requested size, so use whatever our peers see
+		this->segment_size = peers.at(local_nid).segment_size;
+
+		// We never use any RMA synchronization other than MPI_Win_sync, which requires a passive target epoch
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+	}
+
+	shared_memory_transport::~shared_memory_transport() {
+		// Our peers only release payloads once they've read them, so all outgoing releases complete eventually
+		while(!outgoing_releases.empty()) {
+			outgoing_releases.test_some([](const std::unique_ptr<size_t>&) {});
+		}
+		if(window != MPI_WIN_NULL) {
+			MPI_Win_unlock_all(window);
+			MPI_Win_free(&window);
+		}
+		MPI_Comm_free(&host_comm);
+	}
+
+	bool shared_memory_transport::is_shared_memory_transfer(node_id source, node_id target, size_t size) const {
+		if(source == target || peers.count(source) == 0 || peers.count(target) == 0) return false;
+		return get_aligned_size(size) <= peers.at(source).segment_size;
+	}
+
+	size_t shared_memory_transport::allocate(size_t size) {
+		size = get_aligned_size(size);
+		if(allocations.empty()) { head = 0; }
+		const size_t tail = allocations.empty() ? 0 : allocations.front().offset;
+
+		// The free space is [head, tail) if that is non-empty, or [head, segment_size) and [0, tail) otherwise.
+		// Allocations must never end exactly at the tail, as that would make a full ring indistinguishable from an empty one.
+		size_t offset = no_space;
+		if(allocations.empty() || head > tail) {
+			if(head + size <= segment_size) {
+				offset = head;
+			} else if(size < tail) {
+				offset = 0;
+			}
+		} else if(head + size < tail) {
+			offset = head;
+		}
+		if(offset == no_space) return no_space;
+
+		allocations.push_back(allocation{offset, size, false});
+		head = offset + size;
+		return offset;
+	}
+
+	void shared_memory_transport::release(size_t offset) {
+		for(auto& a : allocations) {
+			if(a.offset == offset && !a.released) {
+				a.released = true;
+				break;
+			}
+		}
+		while(!allocations.empty() && allocations.front().released) {
+			allocations.pop_front();
+		}
+	}
+
+	void shared_memory_transport::sync() {
+		if(window != MPI_WIN_NULL) { MPI_Win_sync(window); }
+	}
+
+	void shared_memory_transport::release_peer_payload(node_id nid, size_t offset) {
+		auto r = std::make_unique<size_t>(offset);
+		const size_t* origin = r.get();
+		MPI_Isend(origin, sizeof(size_t), MPI_BYTE, static_cast<int>(nid), mpi_support::TAG_SHM_RELEASE, MPI_COMM_WORLD, outgoing_releases.add(std::move(r)));
+	}
+
+	bool shared_memory_transport::poll() {
+		if(window == MPI_WIN_NULL) return false;
+		bool progress = false;
+		while(true) {
+			int flag;
+			MPI_Message msg;
+			MPI_Improbe(MPI_ANY_SOURCE, mpi_support::TAG_SHM_RELEASE, MPI_COMM_WORLD, &flag, &msg, MPI_STATUS_IGNORE);
+			if(flag == 0) break;
+			size_t offset;
+			MPI_Mrecv(&offset, sizeof(size_t), MPI_BYTE, &msg, MPI_STATUS_IGNORE);
+			// Make sure the peer is done reading before we overwrite the memory
+			sync();
+			release(offset);
+			progress = true;
+		}
+
+		progress = outgoing_releases.test_some([](const std::unique_ptr<size_t>&) {}) || progress;
+		return progress;
+	}
+
+} // namespace detail
+} // namespace celerity
@@ -0,0 +1,72 @@
+#include "staging_buffer_pool.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace celerity {
+namespace detail {
+
+	constexpr size_t staging_buffer_pool::min_block_size;
+	constexpr size_t staging_buffer_pool::max_retained_bytes;
+
+	staging_buffer_pool& staging_buffer_pool::get_instance() {
+		// Intentionally never destroyed, so the pool outlives any staging buffers held by other static objects
+		static auto* instance = new staging_buffer_pool;
+		return *instance;
+	}
+
+	staging_buffer_pool::~staging_buffer_pool() {
+		for(auto& blocks : free_blocks) {
+			for(void* block : blocks) {
+				std::free(block);
+			}
+		}
+	}
+
+	std::pair<size_t, size_t> staging_buffer_pool::get_size_class(size_t size) {
+		if(size <= min_block_size) return {0, min_block_size};
+		// Find the power of two p with p < size <= 2p, then round up to the next multiple of p/4
+		size_t exponent = 0;
+		while((min_block_size << (exponent + 1)) < size) {
+			exponent++;
+		}
+		const size_t p = min_block_size << exponent;
+		const size_t step = p / 4;
+		const size_t block_size = (size + step - 1) / step * step;
+		return {exponent * 4 + (block_size - p) / step, block_size};
+	}
+
+	void* staging_buffer_pool::allocate(size_t size) {
+		const auto size_class = get_size_class(size);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(size_class.first < free_blocks.size() && !free_blocks[size_class.first].empty()) {
+				void* block = free_blocks[size_class.first].back();
+				free_blocks[size_class.first].pop_back();
+				retained_bytes -= size_class.second;
+				return block;
+			}
+		}
+		void* block = std::malloc(size_class.second);
+		if(block == nullptr) throw std::bad_alloc();
+		return block;
+	}
+
+	void staging_buffer_pool::free(void* ptr, size_t size) {
+		assert(ptr != nullptr);
+		const auto size_class = get_size_class(size);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if(retained_bytes + size_class.second <= max_retained_bytes) {
+				if(free_blocks.size() <= size_class.first) { free_blocks.resize(size_class.first + 1); }
+				free_blocks[size_class.first].push_back(ptr);
+				retained_bytes += size_class.second;
+				return;
+			}
+		}
+		std::free(ptr);
+	}
+
+} // namespace detail
+} // namespace celerity
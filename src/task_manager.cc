@@ -11,7 +11,6 @@ namespace detail {
 		// TODO: Not the cleanest solution, especially since it doesn't have an associated task object.
 		task_map[init_task_id] = nullptr;
 		boost::add_vertex(task_graph);
-		task_graph[init_task_id].label = fmt::format("Task {} <INIT>", static_cast<size_t>(init_task_id));
 		task_graph[init_task_id].processed = true;
 	}
 
@@ -44,7 +43,8 @@ namespace detail {
 	void task_manager::print_graph(logger& graph_logger) const {
 		const auto locked_tdag = get_task_graph();
 		if((*locked_tdag).m_vertices.size() < 200) {
-			graph_utils::print_graph(*locked_tdag, graph_logger);
+			graph_utils::print_graph(
+			    *locked_tdag, [this](task_id tid) { return graph_utils::get_task_label(tid, task_map.at(tid).get()); }, graph_logger);
 		} else {
 			graph_logger.warn("Task graph is very large ({} vertices). Skipping GraphViz output", (*locked_tdag).m_vertices.size());
 		}
@@ -0,0 +1,103 @@
+#include "transformers/load_balancing_split.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "command.h"
+#include "graph_builder.h"
+#include "ranges.h"
+#include "task.h"
+#include "transformers/split_utils.h"
+
+namespace celerity {
+namespace detail {
+
+	constexpr double load_balancing_split_transformer::default_damping;
+
+	load_balancing_split_transformer::load_balancing_split_transformer(
+	    size_t num_workers, double damping, std::vector<double> pinned_weights, size_t chunks_per_node, size_t forced_work_group_size)
+	    : num_workers(num_workers), chunks_per_node(chunks_per_node), forced_work_group_size(forced_work_group_size), damping(damping),
+	      weights_pinned(!pinned_weights.empty()), throughputs(num_workers, 0.0) {
+		assert(chunks_per_node > 0);
+		if(damping < 0.0 || damping >= 1.0) { throw std::runtime_error(fmt::format("Invalid load balancing damping factor {}", damping)); }
+		if(weights_pinned) {
+			if(pinned_weights.size() != num_workers) {
+				throw std::runtime_error(fmt::format("Expected {} split weights (one per node), got {}", num_workers, pinned_weights.size()));
+			}
+			if(std::any_of(pinned_weights.cbegin(), pinned_weights.cend(), [](double w) { return w < 0.0; })
+			    || std::accumulate(pinned_weights.cbegin(), pinned_weights.cend(), 0.0) <= 0.0) {
+				throw std::runtime_error("Split weights must be non-negative and not all zero");
+			}
+			throughputs = std::move(pinned_weights);
+		}
+	}
+
+	void load_balancing_split_transformer::set_master_weight(double weight) {
+		assert(weight >= 0.0 && weight <= 1.0);
+		master_weight = weight;
+	}
+
+	void load_balancing_split_transformer::report_throughput(node_id nid, size_t work_items, std::chrono::microseconds duration) {
+		if(weights_pinned) return;
+		assert(nid < num_workers);
+		const double sample = static_cast<double>(work_items) / std::max<std::chrono::microseconds::rep>(duration.count(), 1);
+		std::lock_guard<std::mutex> lock(throughputs_mutex);
+		auto& estimate = throughputs[nid];
+		estimate = estimate == 0.0 ? sample : damping * estimate + (1.0 - damping) * sample;
+	}
+
+	std::vector<double> load_balancing_split_transformer::get_weights() const {
+		std::vector<double> weights;
+		{
+			std::lock_guard<std::mutex> lock(throughputs_mutex);
+			weights = throughputs;
+		}
+		if(!weights_pinned) {
+			// Nodes we haven't heard from yet are assumed to be average.
+			const size_t num_measured = std::count_if(weights.cbegin(), weights.cend(), [](double w) { return w > 0.0; });
+			const double mean = num_measured > 0 ? std::accumulate(weights.cbegin(), weights.cend(), 0.0) / num_measured : 1.0;
+			for(auto& w : weights) {
+				if(w == 0.0) w = mean;
+				w = std::max(w, min_relative_weight * mean);
+			}
+		}
+
+		// The master node's share is reduced on top of its measured (or pinned) weight, unless it is the only node with a non-zero weight.
+		if(std::any_of(weights.cbegin() + 1, weights.cend(), [](double w) { return w > 0.0; })) { weights[0] *= master_weight; }
+
+		const double sum = std::accumulate(weights.cbegin(), weights.cend(), 0.0);
+		for(auto& w : weights) {
+			w /= sum;
+		}
+		return weights;
+	}
+
+	void load_balancing_split_transformer::transform_task(const std::shared_ptr<const task>& tsk, scoped_graph_builder& gb) {
+		if(tsk->get_type() != task_type::COMPUTE) return;
+		const auto ctsk = dynamic_cast<const compute_task*>(tsk.get());
+		if(num_workers == 1) return;
+
+		// Each node's share is divided evenly among its consecutive chunks.
+		std::vector<double> weights;
+		for(auto w : get_weights()) {
+			weights.insert(weights.end(), chunks_per_node, w / chunks_per_node);
+		}
+
+		const size_t granularity = get_split_granularity(*ctsk, forced_work_group_size);
+		auto computes = gb.get_commands(command::COMPUTE);
+		for(auto& cid : computes) {
+			auto& cmd_data = gb.get_command_data(cid);
+			const subrange<3> sr = cmd_data.data.compute.subrange;
+			const chunk<3> full_chunk(sr.offset, sr.range, ctsk->get_global_size());
+			split_weighted_and_assign(gb, cid, full_chunk, weights, chunks_per_node, granularity);
+		}
+
+		gb.commit();
+	}
+
+} // namespace detail
+} // namespace celerity
@@ -1,81 +1,83 @@
 #include "transformers/naive_split.h"
 
+#include <algorithm>
 #include <cassert>
-#include <numeric>
 #include <vector>
 
 #include "command.h"
 #include "graph_builder.h"
 #include "ranges.h"
 #include "task.h"
+#include "transformers/split_utils.h"
 
 namespace celerity {
 namespace detail {
 
-	std::vector<chunk<3>> split_equal(const chunk<1>& full_chunk, size_t num_chunks) {
-		assert(num_chunks > 0);
-		chunk<1> chnk;
-		chnk.global_size = full_chunk.global_size;
-		chnk.offset = full_chunk.offset;
-		chnk.range = cl::sycl::range<1>(full_chunk.range.size() / num_chunks);
-
-		std::vector<chunk<3>> result;
-		for(auto i = 0u; i < num_chunks; ++i) {
-			result.push_back(chnk);
-			chnk.offset = chnk.offset + chnk.range;
-			if(i == num_chunks - 1) { result[i].range[0] += full_chunk.range.size() % num_chunks; }
-		}
-		return result;
+	naive_split_transformer::naive_split_transformer(size_t num_workers, size_t chunks_per_node, double master_weight, size_t forced_work_group_size)
+	    : num_workers(num_workers), chunks_per_node(chunks_per_node), forced_work_group_size(forced_work_group_size), master_weight(master_weight) {
+		assert(chunks_per_node > 0);
+		assert(master_weight >= 0.0 && master_weight <= 1.0);
 	}
 
-	// We simply split by row for now
-	// TODO: There's other ways to split in 2D as well.
-	std::vector<chunk<3>> split_equal(const chunk<2>& full_chunk, size_t num_chunks) {
-		const auto rows =
-		    split_equal(chunk<1>{cl::sycl::id<1>(full_chunk.offset[0]), cl::sycl::range<1>(full_chunk.range[0]), cl::sycl::range<1>(full_chunk.global_size[0])},
-		        num_chunks);
-		std::vector<chunk<3>> result;
-		for(auto& row : rows) {
-			result.push_back(
-			    chunk<2>{cl::sycl::id<2>(row.offset[0], full_chunk.offset[1]), cl::sycl::range<2>(row.range[0], full_chunk.range[1]), full_chunk.global_size});
-		}
-		return result;
+	void naive_split_transformer::set_master_weight(double weight) {
+		assert(weight >= 0.0 && weight <= 1.0);
+		master_weight = weight;
 	}
 
-	std::vector<chunk<3>> split_equal(const chunk<3>& full_chunk, size_t num_chunks) { throw std::runtime_error("3D split_equal NYI"); }
-
-	naive_split_transformer::naive_split_transformer(size_t num_workers) : num_workers(num_workers) {}
-
 	void naive_split_transformer::transform_task(const std::shared_ptr<const task>& tsk, scoped_graph_builder& gb) {
 		if(tsk->get_type() != task_type::COMPUTE) return;
 		const auto ctsk = dynamic_cast<const compute_task*>(tsk.get());
 		if(num_workers == 1) return;
 
-		std::vector<node_id> nodes(num_workers);
-		std::iota(nodes.begin(), nodes.end(), 0);
-
+		// Chunk boundaries have to respect the kernel's work-group size (or any other granularity requested by the user)
+		const size_t granularity = get_split_granularity(*ctsk, forced_work_group_size);
+		const size_t num_chunks = num_workers * chunks_per_node;
 		auto computes = gb.get_commands(command::COMPUTE);
+
+		if(master_weight != 1.0) {
+			// The master node receives a reduced share, all other nodes are split equally.
+			std::vector<double> weights(num_chunks, 1.0 / chunks_per_node);
+			std::fill(weights.begin(), weights.begin() + chunks_per_node, master_weight / chunks_per_node);
+			for(auto& cid : computes) {
+				const subrange<3> sr = gb.get_command_data(cid).data.compute.subrange;
+				const chunk<3> full_chunk(sr.offset, sr.range, ctsk->get_global_size());
+				split_weighted_and_assign(gb, cid, full_chunk, weights, chunks_per_node, granularity);
+			}
+			gb.commit();
+			return;
+		}
+
 		for(auto& cid : computes) {
 			auto& cmd_data = gb.get_command_data(cid);
 			const subrange<3> sr = cmd_data.data.compute.subrange;
 
-			std::vector<chunk<3>> chunks;
+			std::vector<chunk<3>> equal_chunks;
 			switch(ctsk->get_dimensions()) {
 			case 1: {
 				const chunk<1> full_chunk(detail::id_cast<1>(sr.offset), detail::range_cast<1>(sr.range), detail::range_cast<1>(ctsk->get_global_size()));
-				chunks = split_equal(full_chunk, num_workers);
+				equal_chunks = split_equal(full_chunk, num_chunks, granularity);
 			} break;
 			case 2: {
 				const chunk<2> full_chunk(detail::id_cast<2>(sr.offset), detail::range_cast<2>(sr.range), detail::range_cast<2>(ctsk->get_global_size()));
-				chunks = split_equal(full_chunk, num_workers);
+				equal_chunks = split_equal(full_chunk, num_chunks, granularity);
 			} break;
 			case 3: {
 				const chunk<3> full_chunk(detail::id_cast<3>(sr.offset), detail::range_cast<3>(sr.range), detail::range_cast<3>(ctsk->get_global_size()));
-				chunks = split_equal(full_chunk, num_workers);
+				equal_chunks = split_equal(full_chunk, num_chunks, granularity);
 			} break;
 			default: assert(false);
 			}
 
+			// Consecutive chunks are assigned to the same node, so only the outermost chunks of each node require data from other nodes.
+			// If there are fewer granules than chunks, some chunks are empty. We omit those altogether.
+			std::vector<chunk<3>> chunks;
+			std::vector<node_id> nodes;
+			for(auto i = 0u; i < num_chunks; ++i) {
+				if(equal_chunks[i].range.size() == 0) continue;
+				chunks.push_back(equal_chunks[i]);
+				nodes.push_back(i / chunks_per_node);
+			}
+
 			gb.split_command(cid, chunks, nodes);
 		}
 
@@ -0,0 +1,103 @@
+#include "transformers/split_utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "graph_builder.h"
+#include "task.h"
+
+namespace celerity {
+namespace detail {
+
+	namespace {
+
+		size_t gcd(size_t a, size_t b) { return b == 0 ? a : gcd(b, a % b); }
+
+	} // namespace
+
+	size_t get_split_granularity(const compute_task& ctsk, size_t forced_work_group_size) {
+		const size_t hint = std::max<size_t>(1, ctsk.get_split_granularity()[0]);
+		if(forced_work_group_size == 0) return hint;
+		return hint / gcd(hint, forced_work_group_size) * forced_work_group_size;
+	}
+
+	std::vector<chunk<3>> split_equal(const chunk<1>& full_chunk, size_t num_chunks, size_t granularity) {
+		assert(num_chunks > 0);
+		assert(granularity > 0);
+		const size_t granules = full_chunk.range[0] / granularity;
+
+		std::vector<chunk<3>> result;
+		size_t begin = 0;
+		for(auto i = 0u; i < num_chunks; ++i) {
+			// Spread the granules that can't be divided equally over all chunks, instead of assigning them to a single one
+			const size_t end = i == num_chunks - 1 ? full_chunk.range[0] : (i + 1) * granules / num_chunks * granularity;
+			chunk<1> chnk;
+			chnk.global_size = full_chunk.global_size;
+			chnk.offset = full_chunk.offset + cl::sycl::id<1>(begin);
+			chnk.range = cl::sycl::range<1>(end - begin);
+			result.push_back(chnk);
+			begin = end;
+		}
+		return result;
+	}
+
+	// We simply split by row for now
+	// TODO: There's other ways to split in 2D as well.
+	std::vector<chunk<3>> split_equal(const chunk<2>& full_chunk, size_t num_chunks, size_t granularity) {
+		const auto rows =
+		    split_equal(chunk<1>{cl::sycl::id<1>(full_chunk.offset[0]), cl::sycl::range<1>(full_chunk.range[0]), cl::sycl::range<1>(full_chunk.global_size[0])},
+		        num_chunks, granularity);
+		std::vector<chunk<3>> result;
+		for(auto& row : rows) {
+			result.push_back(
+			    chunk<2>{cl::sycl::id<2>(row.offset[0], full_chunk.offset[1]), cl::sycl::range<2>(row.range[0], full_chunk.range[1]), full_chunk.global_size});
+		}
+		return result;
+	}
+
+	std::vector<chunk<3>> split_equal(const chunk<3>& full_chunk, size_t num_chunks, size_t granularity) { throw std::runtime_error("3D split_equal NYI"); }
+
+	std::vector<chunk<3>> split_weighted(const chunk<3>& full_chunk, const std::vector<double>& weights, size_t granularity) {
+		assert(!weights.empty());
+		assert(granularity > 0);
+		const double weight_sum = std::accumulate(weights.cbegin(), weights.cend(), 0.0);
+		assert(weight_sum > 0.0);
+
+		const size_t rows = full_chunk.range[0];
+		const size_t granules = rows / granularity;
+		std::vector<chunk<3>> result;
+		double cumulative_weight = 0.0;
+		size_t row_begin = 0;
+		for(auto i = 0u; i < weights.size(); ++i) {
+			cumulative_weight += weights[i];
+			// Make sure the last chunk always ends at the very last row, regardless of floating point rounding
+			const size_t row_end = i == weights.size() - 1
+			                           ? rows
+			                           : std::min(granules, static_cast<size_t>(std::llround(granules * cumulative_weight / weight_sum))) * granularity;
+			chunk<3> chnk = full_chunk;
+			chnk.offset[0] = full_chunk.offset[0] + row_begin;
+			chnk.range[0] = row_end - row_begin;
+			result.push_back(chnk);
+			row_begin = row_end;
+		}
+		return result;
+	}
+
+	void split_weighted_and_assign(scoped_graph_builder& gb, command_id cid, const chunk<3>& full_chunk, const std::vector<double>& weights,
+	    size_t chunks_per_node, size_t granularity) {
+		std::vector<chunk<3>> chunks;
+		std::vector<node_id> nodes;
+		const auto weighted_chunks = split_weighted(full_chunk, weights, granularity);
+		for(auto i = 0u; i < weighted_chunks.size(); ++i) {
+			if(weighted_chunks[i].range.size() == 0) continue;
+			chunks.push_back(weighted_chunks[i]);
+			nodes.push_back(i / chunks_per_node);
+		}
+		gb.split_command(cid, chunks, nodes);
+	}
+
+} // namespace detail
+} // namespace celerity
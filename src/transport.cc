@@ -0,0 +1,69 @@
+#include "transport.h"
+
+#include <cassert>
+
+namespace celerity {
+namespace detail {
+
+	mpi_transport::mpi_transport() {
+		int world_size;
+		MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+		num_nodes = static_cast<size_t>(world_size);
+		int world_rank;
+		MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+		local_nid = static_cast<node_id>(world_rank);
+	}
+
+	void mpi_transport::send(node_id target, channel ch, std::vector<unsigned char> message) {
+		// Even though control messages are usually small enough to use a blocking send we want to be able to send to ourselves as well,
+		// which is why we have to use Isend after all.
+		MPI_Request* req = active_sends.add(send_handle{target, std::move(message)});
+		const auto& handle = active_sends.back();
+		MPI_Isend(handle.message.data(), static_cast<int>(handle.message.size()), MPI_BYTE, static_cast<int>(target), get_tag(ch), MPI_COMM_WORLD, req);
+	}
+
+	void mpi_transport::poll_sends(const sent_callback& on_sent) {
+		active_sends.test_some([&on_sent](send_handle& handle) { on_sent(handle.target, std::move(handle.message)); });
+	}
+
+	bool mpi_transport::try_receive(channel ch, node_id& source, std::vector<unsigned char>& message) {
+		MPI_Status status;
+		int flag;
+		MPI_Message msg;
+		MPI_Improbe(MPI_ANY_SOURCE, get_tag(ch), MPI_COMM_WORLD, &flag, &msg, &status);
+		if(flag == 0) return false;
+
+		// Control messages should be small enough to block here
+		int count;
+		MPI_Get_count(&status, MPI_BYTE, &count);
+		message.resize(count);
+		MPI_Mrecv(message.data(), count, MPI_BYTE, &msg, &status);
+		source = static_cast<node_id>(status.MPI_SOURCE);
+		return true;
+	}
+
+	loopback_transport::network::network(size_t num_nodes) : num_nodes(num_nodes), mailboxes(num_nodes * 2) {}
+
+	loopback_transport::loopback_transport(std::shared_ptr<network> net, node_id local_nid) : net(std::move(net)), local_nid(local_nid) {
+		assert(local_nid < this->net->get_num_nodes());
+	}
+
+	void loopback_transport::send(node_id target, channel ch, std::vector<unsigned char> message) {
+		assert(target < net->get_num_nodes());
+		auto& mb = net->get_mailbox(target, ch);
+		std::lock_guard<std::mutex> lock(mb.mutex);
+		mb.messages.push_back(network::message{local_nid, std::move(message)});
+	}
+
+	bool loopback_transport::try_receive(channel ch, node_id& source, std::vector<unsigned char>& message) {
+		auto& mb = net->get_mailbox(local_nid, ch);
+		std::lock_guard<std::mutex> lock(mb.mutex);
+		if(mb.messages.empty()) return false;
+		source = mb.messages.front().source;
+		message = std::move(mb.messages.front().data);
+		mb.messages.pop_front();
+		return true;
+	}
+
+} // namespace detail
+} // namespace celerity
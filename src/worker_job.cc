@@ -1,5 +1,7 @@
 #include "worker_job.h"
 
+#include <algorithm>
+
 #include <spdlog/fmt/fmt.h>
 
 #include "device_queue.h"
@@ -18,7 +20,7 @@ namespace detail {
 	void worker_job::update() {
 		assert(running && !done);
 		const auto before = std::chrono::steady_clock::now();
-		done = execute(pkg, job_logger);
+		done = execute(pkg);
 
 		// TODO: We may want to make benchmarking optional with a macro
 		const auto dt = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before);
@@ -28,11 +30,12 @@ namespace detail {
 		if(dt > bench_max) bench_max = dt;
 
 		if(done) {
+			execution_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time);
+			if(!tracing) return;
 			const auto bench_avg = bench_sum_execution_time.count() / bench_sample_count;
-			const auto execution_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
-			job_logger->trace(logger_map({{"event", "STOP"}, {"executionTime", std::to_string(execution_time)}, {"pollDurationAvg", std::to_string(bench_avg)},
-			    {"pollDurationMin", std::to_string(bench_min.count())}, {"pollDurationMax", std::to_string(bench_max.count())},
-			    {"pollSamples", std::to_string(bench_sample_count)}}));
+			get_logger().trace(logger_map({{"event", "STOP"}, {"executionTime", std::to_string(execution_time.count())},
+			    {"pollDurationAvg", std::to_string(bench_avg)}, {"pollDurationMin", std::to_string(bench_min.count())},
+			    {"pollDurationMax", std::to_string(bench_max.count())}, {"pollSamples", std::to_string(bench_sample_count)}}));
 		}
 	}
 
@@ -40,12 +43,19 @@ namespace detail {
 		assert(!running);
 		running = true;
 
-		auto job_description = get_description(pkg);
-		job_logger->trace(logger_map({{"cid", std::to_string(pkg.cid)}, {"event", "START"},
-		    {"type", command_string[static_cast<std::underlying_type_t<command>>(job_description.first)]}, {"message", job_description.second}}));
+		if(tracing) {
+			auto job_description = get_description(pkg);
+			get_logger().trace(logger_map({{"cid", std::to_string(pkg.cid)}, {"event", "START"},
+			    {"type", command_string[static_cast<std::underlying_type_t<command>>(job_description.first)]}, {"message", job_description.second}}));
+		}
 		start_time = std::chrono::steady_clock::now();
 	}
 
+	logger& worker_job::get_logger() {
+		if(job_logger == nullptr) { job_logger = execution_logger->create_context({{"task", std::to_string(pkg.tid)}, {"job", std::to_string(pkg.cid)}}); }
+		return *job_logger;
+	}
+
 
 	// --------------------------------------------------------------------------------------------------------------------
 	// --------------------------------------------------- AWAIT PUSH -----------------------------------------------------
@@ -56,7 +66,7 @@ namespace detail {
 		    fmt::format("AWAIT PUSH of buffer {} by node {}", static_cast<size_t>(pkg.data.await_push.bid), static_cast<size_t>(pkg.data.await_push.source)));
 	}
 
-	bool await_push_job::execute(const command_pkg& pkg, std::shared_ptr<logger> logger) {
+	bool await_push_job::execute(const command_pkg& pkg) {
 		if(data_handle == nullptr) { data_handle = btm.await_push(pkg); }
 		return data_handle->complete;
 	}
@@ -71,11 +81,11 @@ namespace detail {
 		    command::PUSH, fmt::format("PUSH buffer {} to node {}", static_cast<size_t>(pkg.data.push.bid), static_cast<size_t>(pkg.data.push.target)));
 	}
 
-	bool push_job::execute(const command_pkg& pkg, std::shared_ptr<logger> logger) {
+	bool push_job::execute(const command_pkg& pkg) {
 		if(data_handle == nullptr) {
-			logger->trace(logger_map({{"event", "Submit buffer to BTM"}}));
+			if(is_tracing()) get_logger().trace(logger_map({{"event", "Submit buffer to BTM"}}));
 			data_handle = btm.push(pkg);
-			logger->trace(logger_map({{"event", "Buffer submitted to BTM"}}));
+			if(is_tracing()) get_logger().trace(logger_map({{"event", "Buffer submitted to BTM"}}));
 		}
 		return data_handle->complete;
 	}
@@ -84,7 +94,10 @@ namespace detail {
 	// ------------------------------------------------------ COMPUTE -----------------------------------------------------
 	// --------------------------------------------------------------------------------------------------------------------
 
-	std::pair<command, std::string> compute_job::get_description(const command_pkg& pkg) { return std::make_pair(command::COMPUTE, "COMPUTE"); }
+	std::pair<command, std::string> compute_job::get_description(const command_pkg& pkg) {
+		if(pkg.data.compute.fused_tasks == 0) { return std::make_pair(command::COMPUTE, "COMPUTE"); }
+		return std::make_pair(command::COMPUTE, fmt::format("COMPUTE (fused tasks {} - {})", pkg.tid, pkg.tid + pkg.data.compute.fused_tasks));
+	}
 
 // While device profiling is disabled on hipSYCL anyway, we have to make sure that we don't include any OpenCL code
 #if !WORKAROUND(HIPSYCL, 0)
@@ -97,24 +110,28 @@ namespace detail {
 	};
 #endif
 
-	bool compute_job::execute(const command_pkg& pkg, std::shared_ptr<logger> logger) {
+	bool compute_job::execute(const command_pkg& pkg) {
+		// Fused tasks always directly follow the task of the command itself
+		const task_id last_tid = pkg.tid + pkg.data.compute.fused_tasks;
+
 		// A bit of a hack: We cannot be sure the main thread has reached the task definition yet, so we have to check it here
-		if(!task_mngr.has_task(pkg.tid)) {
+		if(!task_mngr.has_task(last_tid)) {
 			if(!did_log_task_wait) {
-				logger->trace(logger_map({{"event", "Waiting for task definition"}}));
+				if(is_tracing()) get_logger().trace(logger_map({{"event", "Waiting for task definition"}}));
 				did_log_task_wait = true;
 			}
 			return false;
 		}
 
-		if(!submitted) {
+		if(events.empty()) {
 			// Note that we have to set the proper global size so the livepass handler can use the assigned chunk as input for range mappers
-			const auto ctsk = std::static_pointer_cast<const detail::compute_task>(task_mngr.get_task(pkg.tid));
 			auto& cmd_sr = pkg.data.compute.subrange;
-			logger->trace(logger_map({{"event", "Execute live-pass, submit kernel to SYCL"}}));
-			event = queue.execute(pkg.tid, cmd_sr);
-			submitted = true;
-			logger->trace(logger_map({{"event", "Submitted"}}));
+			if(is_tracing()) get_logger().trace(logger_map({{"event", "Execute live-pass, submit kernel to SYCL"}}));
+			// Kernels of fused tasks are submitted back-to-back, SYCL takes care of the dependencies between them.
+			for(task_id tid = pkg.tid; tid <= last_tid; ++tid) {
+				events.push_back(queue.execute(tid, cmd_sr));
+			}
+			if(is_tracing()) get_logger().trace(logger_map({{"event", "Submitted"}}));
 
 			// There currently (since 0.9.0 and up to and including 1.0.5) exists a bug that causes ComputeCpp to block when
 			// querying the execution status of a compute command until it is finished. This is bad for us, as it blocks all other
@@ -123,9 +140,11 @@ namespace detail {
 			// The workaround for now is to block within a worker thread.
 #if WORKAROUND(COMPUTECPP, 1, 0, 5)
 			computecpp_workaround_future = runtime::get_instance().execute_async_pooled([this]() {
-				while(true) {
-					const auto status = event.get_info<cl::sycl::info::event::command_execution_status>();
-					if(status == cl::sycl::info::event_command_status::complete) { return; }
+				for(auto& event : events) {
+					while(true) {
+						const auto status = event.get_info<cl::sycl::info::event::command_execution_status>();
+						if(status == cl::sycl::info::event_command_status::complete) { break; }
+					}
 				}
 			});
 #endif
@@ -135,23 +154,27 @@ namespace detail {
 		assert(computecpp_workaround_future.valid());
 		if(computecpp_workaround_future.wait_for(std::chrono::microseconds(1)) == std::future_status::ready) {
 #else
-		const auto status = event.get_info<cl::sycl::info::event::command_execution_status>();
-		if(status == cl::sycl::info::event_command_status::complete) {
+		const bool all_complete = std::all_of(events.cbegin(), events.cend(), [](const cl::sycl::event& event) {
+			return event.get_info<cl::sycl::info::event::command_execution_status>() == cl::sycl::info::event_command_status::complete;
+		});
+		if(all_complete) {
 #endif
 #if !WORKAROUND(HIPSYCL, 0)
-			if(queue.is_profiling_enabled()) {
-				const auto queued = get_profiling_info(event.get(), CL_PROFILING_COMMAND_QUEUED);
-				const auto submit = get_profiling_info(event.get(), CL_PROFILING_COMMAND_SUBMIT);
-				const auto start = get_profiling_info(event.get(), CL_PROFILING_COMMAND_START);
-				const auto end = get_profiling_info(event.get(), CL_PROFILING_COMMAND_END);
-
-				// FIXME: The timestamps logged here don't match the actual values we just queried. Can we fix that?
-				logger->trace(logger_map({{"event",
-				    fmt::format("Delta time queued -> submit : {}us", std::chrono::duration_cast<std::chrono::microseconds>(submit - queued).count())}}));
-				logger->trace(logger_map({{"event",
-				    fmt::format("Delta time submit -> start: {}us", std::chrono::duration_cast<std::chrono::microseconds>(start - submit).count())}}));
-				logger->trace(logger_map(
-				    {{"event", fmt::format("Delta time start -> end: {}us", std::chrono::duration_cast<std::chrono::microseconds>(end - start).count())}}));
+			if(queue.is_profiling_enabled() && is_tracing()) {
+				for(auto& event : events) {
+					const auto queued = get_profiling_info(event.get(), CL_PROFILING_COMMAND_QUEUED);
+					const auto submit = get_profiling_info(event.get(), CL_PROFILING_COMMAND_SUBMIT);
+					const auto start = get_profiling_info(event.get(), CL_PROFILING_COMMAND_START);
+					const auto end = get_profiling_info(event.get(), CL_PROFILING_COMMAND_END);
+
+					// FIXME: The timestamps logged here don't match the actual values we just queried. Can we fix that?
+					get_logger().trace(logger_map({{"event",
+					    fmt::format("Delta time queued -> submit : {}us", std::chrono::duration_cast<std::chrono::microseconds>(submit - queued).count())}}));
+					get_logger().trace(logger_map({{"event",
+					    fmt::format("Delta time submit -> start: {}us", std::chrono::duration_cast<std::chrono::microseconds>(start - submit).count())}}));
+					get_logger().trace(logger_map({{"event",
+					    fmt::format("Delta time start -> end: {}us", std::chrono::duration_cast<std::chrono::microseconds>(end - start).count())}}));
+				}
 			}
 #endif
 			return true;
@@ -167,7 +190,7 @@ namespace detail {
 		return std::make_pair(command::MASTER_ACCESS, "MASTER ACCESS");
 	}
 
-	bool master_access_job::execute(const command_pkg& pkg, std::shared_ptr<logger> logger) {
+	bool master_access_job::execute(const command_pkg& pkg) {
 		// In this case we can be sure that the task definition exists, as we're on the master node.
 		const auto tsk = std::static_pointer_cast<const master_access_task>(task_mngr.get_task(pkg.tid));
 		auto cgh = std::make_unique<master_access_task_handler<false>>();
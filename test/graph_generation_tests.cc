@@ -1,7 +1,10 @@
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <set>
+#include <utility>
+#include <vector>
 
 // Use custom main(), see below
 #define CATCH_CONFIG_RUNNER
@@ -17,6 +20,8 @@
 #include "graph_generator.h"
 #include "graph_utils.h"
 #include "task_manager.h"
+#include "transformers/load_balancing_split.h"
+#include "transformers/naive_split.h"
 
 #include "test_utils.h"
 
@@ -318,8 +323,8 @@ namespace detail {
 		REQUIRE(GRAPH_PROP(cdag, next_cmd_id) == 0);
 		REQUIRE(GRAPH_PROP(cdag, command_vertices).empty());
 		graph_builder gb(cdag);
-		const auto cid_0 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{}, "Foo");
-		const auto cid_1 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{}, "Foo");
+		const auto cid_0 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{});
+		const auto cid_1 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{});
 		REQUIRE(GRAPH_PROP(cdag, next_cmd_id) == 2);
 		gb.commit();
 		REQUIRE(GRAPH_PROP(cdag, command_vertices).count(cid_0) == 1);
@@ -329,8 +334,8 @@ namespace detail {
 	TEST_CASE("graph_builder correctly creates dependencies", "[graph_builder]") {
 		command_dag cdag;
 		graph_builder gb(cdag);
-		const auto cid_0 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{}, "Foo");
-		const auto cid_1 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{}, "Foo");
+		const auto cid_0 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{});
+		const auto cid_1 = gb.add_command(cdag_vertex_none, cdag_vertex_none, 0, 0, command::NOP, command_data{});
 		gb.add_dependency(cid_1, cid_0, true);
 		gb.add_dependency(cid_1, cid_0, true);
 		gb.commit();
@@ -354,7 +359,6 @@ namespace detail {
 	TEST_CASE("graph_builder correctly splits commands", "[graph_builder]") {
 		task_dag tdag;
 		boost::add_vertex(tdag);
-		tdag[0].label = "Foo Task";
 
 		command_dag cdag;
 		graph_builder gb(cdag);
@@ -403,7 +407,6 @@ namespace detail {
 #else
 		task_dag tdag;
 		boost::add_vertex(tdag);
-		tdag[0].label = "Foo Task";
 
 		command_dag cdag;
 		graph_builder gb(cdag);
@@ -480,6 +483,39 @@ namespace detail {
 		std::map<node_id, std::set<command_id>> by_node;
 	};
 
+	/**
+	 * Records the packages of all generated commands, optionally forwarding them to another callback (e.g. a cdag_inspector).
+	 * Unlike cdag_inspector, this can be queried for tasks and nodes that didn't receive any commands.
+	 */
+	class command_pkg_recorder {
+	  public:
+		using flush_callback = std::function<void(node_id, command_pkg, const std::vector<command_id>&)>;
+
+		explicit command_pkg_recorder(flush_callback forward_cb = {}) : forward_cb(std::move(forward_cb)) {}
+
+		flush_callback get_cb() {
+			return [this](node_id nid, command_pkg pkg, const std::vector<command_id>& dependencies) {
+				pkgs.push_back({nid, pkg});
+				if(forward_cb) { forward_cb(nid, pkg, dependencies); }
+			};
+		}
+
+		std::vector<command_pkg> get_pkgs(boost::optional<task_id> tid, boost::optional<node_id> nid, boost::optional<command> cmd) const {
+			std::vector<command_pkg> result;
+			for(const auto& p : pkgs) {
+				if(tid != boost::none && p.second.tid != *tid) continue;
+				if(nid != boost::none && p.first != *nid) continue;
+				if(cmd != boost::none && p.second.cmd != *cmd) continue;
+				result.push_back(p.second);
+			}
+			return result;
+		}
+
+	  private:
+		flush_callback forward_cb;
+		std::vector<std::pair<node_id, command_pkg>> pkgs;
+	};
+
 	task_id build_and_flush(detail::graph_generator& ggen, task_id tid) {
 		ggen.build_task(tid);
 		ggen.flush(tid);
@@ -929,6 +965,111 @@ namespace detail {
 		}
 	}
 
+	TEST_CASE("graph_generator omits dependencies on commands below the completed watermark", "[graph_generator][command-graph]") {
+		using namespace cl::sycl::access;
+
+		task_manager tm{true};
+		cdag_inspector inspector;
+		graph_generator ggen(2, tm, inspector.get_cb());
+		test_utils::mock_buffer_factory mbf(&tm, &ggen);
+		auto buf_a = mbf.create_buffer(cl::sycl::range<1>(100));
+		auto buf_b = mbf.create_buffer(cl::sycl::range<1>(100));
+
+		const auto tid_a = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_a)>(tm,
+		                                             [&](handler& cgh) { buf_a.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+		                                             cl::sycl::range<1>{100}));
+		const auto computes_a = inspector.get_commands(tid_a, node_id(1), command::COMPUTE);
+		const auto tid_b = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_b)>(tm,
+		                                             [&](handler& cgh) { buf_b.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+		                                             cl::sycl::range<1>{100}));
+		const auto computes_b = inspector.get_commands(tid_b, node_id(1), command::COMPUTE);
+		REQUIRE(computes_a.size() == 1);
+		REQUIRE(computes_b.size() == 1);
+
+		// Node 1 reports that the command of task a (but not the one of task b) has completed
+		ggen.set_completed_watermark(node_id(1), *computes_a.cbegin() + 1);
+
+		const auto tid_c = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_c)>(tm,
+		                                             [&](handler& cgh) {
+			                                             buf_a.get_access<mode::read>(cgh, access::one_to_one<1>());
+			                                             buf_b.get_access<mode::read>(cgh, access::one_to_one<1>());
+		                                             },
+		                                             cl::sycl::range<1>{100}));
+		const auto computes_c = inspector.get_commands(tid_c, node_id(1), command::COMPUTE);
+		REQUIRE(computes_c.size() == 1);
+		REQUIRE_FALSE(inspector.has_dependency(*computes_c.cbegin(), *computes_a.cbegin()));
+		REQUIRE(inspector.has_dependency(*computes_c.cbegin(), *computes_b.cbegin()));
+
+		maybe_print_graph(tm);
+		maybe_print_graph(ggen);
+	}
+
+	TEST_CASE("graph_generator omits dependencies that are implied by other dependencies within the same task", "[graph_generator][command-graph]") {
+		using namespace cl::sycl::access;
+
+		task_manager tm{true};
+		cdag_inspector inspector;
+		graph_generator ggen(2, tm, inspector.get_cb());
+		test_utils::mock_buffer_factory mbf(&tm, &ggen);
+		auto buf_a = mbf.create_buffer(cl::sycl::range<1>(100));
+		auto buf_b = mbf.create_buffer(cl::sycl::range<1>(100));
+
+		build_and_flush(ggen, test_utils::add_master_access_task(tm, [&](handler& cgh) { buf_a.get_access<mode::discard_write>(cgh, 100); }));
+		// Node 1 receives all of buffer a before computing its part of buffer b
+		const auto tid_b = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_b)>(tm,
+		                                             [&](handler& cgh) {
+			                                             buf_a.get_access<mode::read>(cgh, access::all<1, 1>());
+			                                             buf_b.get_access<mode::discard_write>(cgh, access::one_to_one<1>());
+		                                             },
+		                                             cl::sycl::range<1>{100}));
+		const auto await_pushes_b = inspector.get_commands(tid_b, node_id(1), command::AWAIT_PUSH);
+		const auto computes_b = inspector.get_commands(tid_b, node_id(1), command::COMPUTE);
+		REQUIRE(await_pushes_b.size() == 1);
+		REQUIRE(computes_b.size() == 1);
+		REQUIRE(inspector.has_dependency(*computes_b.cbegin(), *await_pushes_b.cbegin()));
+
+		// Task c reads data last written by both the AWAIT_PUSH and the COMPUTE of task b, but the latter already depends on the former
+		const auto tid_c = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_c)>(tm,
+		                                             [&](handler& cgh) {
+			                                             buf_a.get_access<mode::read>(cgh, access::all<1, 1>());
+			                                             buf_b.get_access<mode::read>(cgh, access::one_to_one<1>());
+		                                             },
+		                                             cl::sycl::range<1>{100}));
+		const auto computes_c = inspector.get_commands(tid_c, node_id(1), command::COMPUTE);
+		REQUIRE(computes_c.size() == 1);
+		REQUIRE(inspector.has_dependency(*computes_c.cbegin(), *computes_b.cbegin()));
+		REQUIRE_FALSE(inspector.has_dependency(*computes_c.cbegin(), *await_pushes_b.cbegin()));
+
+		maybe_print_graph(tm);
+		maybe_print_graph(ggen);
+	}
+
+	TEST_CASE("graph_utils::find_implied_vertices visits each vertex only once", "[graph_utils]") {
+		// Depending on every command of a long chain is the worst case for checking each pair of dependencies separately
+		command_dag graph;
+		const size_t chain_length = 1000;
+		std::vector<cdag_vertex> chain;
+		for(size_t i = 0; i < chain_length; ++i) {
+			chain.push_back(boost::add_vertex(graph));
+			if(i > 0) { boost::add_edge(chain[i - 1], chain[i], graph); }
+		}
+
+		size_t traversed = 0;
+		const auto implied = graph_utils::find_implied_vertices(graph, chain, [&traversed](cdag_vertex) {
+			traversed++;
+			return true;
+		});
+		REQUIRE(implied.size() == chain_length - 1);
+		REQUIRE(implied.count(chain.back()) == 0);
+		// Each vertex has been reached through a single edge
+		REQUIRE(traversed <= chain_length);
+
+		SECTION("paths are only followed through traversable vertices") {
+			const auto implied_direct = graph_utils::find_implied_vertices(graph, {chain[0], chain[2]}, [&chain](cdag_vertex v) { return v != chain[1]; });
+			REQUIRE(implied_direct.empty());
+		}
+	}
+
 	// This test case currently fails and exists for documentation purposes:
 	//	- Having fixed write access to a buffer results in unclear semantics when it comes to splitting the task into chunks.
 	//  - We could check for write access when using the built-in access::fixed range mapper and warn / throw.
@@ -1200,6 +1341,306 @@ namespace detail {
 		maybe_print_graph(ggen);
 	}
 
+	TEST_CASE("naive_split_transformer assigns multiple consecutive chunks to each node", "[graph_generator][transformer]") {
+		using namespace cl::sycl::access;
+		task_manager tm{true};
+		cdag_inspector inspector;
+		graph_generator ggen(2, tm, inspector.get_cb(), std::make_shared<naive_split_transformer>(2, 2));
+		test_utils::mock_buffer_factory mbf(&tm, &ggen);
+		auto buf_a = mbf.create_buffer(cl::sycl::range<1>(100));
+		auto buf_b = mbf.create_buffer(cl::sycl::range<1>(100));
+
+		const auto tid_a = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_a)>(tm,
+		                                             [&](handler& cgh) { buf_a.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+		                                             cl::sycl::range<1>{100}));
+		REQUIRE(inspector.get_commands(tid_a, node_id(0), command::COMPUTE).size() == 2);
+		REQUIRE(inspector.get_commands(tid_a, node_id(1), command::COMPUTE).size() == 2);
+
+		SECTION("only chunks on node boundaries depend on data transfers") {
+			const auto tid_b = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_b)>(tm,
+			                                             [&](handler& cgh) {
+				                                             buf_a.get_access<mode::read>(cgh, access::neighborhood<1>(1));
+				                                             buf_b.get_access<mode::discard_write>(cgh, access::one_to_one<1>());
+			                                             },
+			                                             cl::sycl::range<1>{100}));
+
+			for(node_id nid : {node_id(0), node_id(1)}) {
+				const auto computes = inspector.get_commands(tid_b, nid, command::COMPUTE);
+				const auto await_pushes = inspector.get_commands(tid_b, nid, command::AWAIT_PUSH);
+				REQUIRE(computes.size() == 2);
+				REQUIRE(await_pushes.size() == 1);
+				const auto await_push_cid = *await_pushes.cbegin();
+				const size_t num_dependants = std::count_if(
+				    computes.cbegin(), computes.cend(), [&](command_id cid) { return inspector.has_dependency(cid, await_push_cid); });
+				CHECK(num_dependants == 1);
+			}
+		}
+
+		SECTION("data is transferred only once per node") {
+			const auto tid_b = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_b)>(tm,
+			                                             [&](handler& cgh) {
+				                                             buf_a.get_access<mode::read>(cgh, access::fixed<1, 1>({0, 100}));
+				                                             buf_b.get_access<mode::discard_write>(cgh, access::one_to_one<1>());
+			                                             },
+			                                             cl::sycl::range<1>{100}));
+
+			// Each node receives the two chunks written by the other node exactly once, and both local chunks depend on them
+			for(node_id nid : {node_id(0), node_id(1)}) {
+				const auto computes = inspector.get_commands(tid_b, nid, command::COMPUTE);
+				const auto await_pushes = inspector.get_commands(tid_b, nid, command::AWAIT_PUSH);
+				REQUIRE(await_pushes.size() == 2);
+				for(auto compute_cid : computes) {
+					for(auto await_push_cid : await_pushes) {
+						CHECK(inspector.has_dependency(compute_cid, await_push_cid));
+					}
+				}
+			}
+		}
+
+		SECTION("chunks on the same node with overlapping writes don't depend on each other") {
+			const auto tid_b = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_b)>(tm,
+			                                             [&](handler& cgh) { buf_a.get_access<mode::discard_write>(cgh, access::neighborhood<1>(1)); },
+			                                             cl::sycl::range<1>{100}));
+
+			const auto computes_a = inspector.get_commands(tid_a, boost::none, command::COMPUTE);
+			for(node_id nid : {node_id(0), node_id(1)}) {
+				const auto computes = inspector.get_commands(tid_b, nid, command::COMPUTE);
+				REQUIRE(computes.size() == 2);
+				for(auto compute_cid : computes) {
+					for(auto other_cid : computes) {
+						CHECK_FALSE(inspector.has_dependency(compute_cid, other_cid));
+					}
+					// Each chunk still has an anti-dependency onto the previous writers of its range
+					const size_t num_anti_deps = std::count_if(
+					    computes_a.cbegin(), computes_a.cend(), [&](command_id cid) { return inspector.has_dependency(compute_cid, cid); });
+					CHECK(num_anti_deps > 0);
+				}
+			}
+		}
+
+		maybe_print_graph(tm);
+		maybe_print_graph(ggen);
+	}
+
+	TEST_CASE("load_balancing_split_transformer splits compute tasks according to per-node weights", "[graph_generator][transformer][load-balancing]") {
+		using namespace cl::sycl::access;
+		task_manager tm{true};
+		command_pkg_recorder recorder;
+
+		const auto get_node_range = [&](task_id tid, node_id nid) -> size_t {
+			const auto computes = recorder.get_pkgs(tid, nid, command::COMPUTE);
+			if(computes.empty()) return 0;
+			REQUIRE(computes.size() == 1);
+			return computes[0].data.compute.subrange.range[0];
+		};
+
+		SECTION("when weights are pinned") {
+			const auto lb_split = std::make_shared<load_balancing_split_transformer>(4, 0.5, std::vector<double>{0.0, 1.0, 1.0, 2.0});
+			graph_generator ggen(4, tm, recorder.get_cb(), lb_split);
+			test_utils::mock_buffer_factory mbf(&tm, &ggen);
+			auto buf = mbf.create_buffer(cl::sycl::range<1>(300));
+
+			// Measurements are ignored if weights are pinned
+			lb_split->report_throughput(0, 1000, std::chrono::microseconds(1));
+
+			const auto tid = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task)>(tm,
+			                                           [&](handler& cgh) { buf.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+			                                           cl::sycl::range<1>{300}));
+			CHECK(get_node_range(tid, 0) == 0);
+			CHECK(get_node_range(tid, 1) == 75);
+			CHECK(get_node_range(tid, 2) == 75);
+			CHECK(get_node_range(tid, 3) == 150);
+		}
+
+		SECTION("when throughput is measured") {
+			const auto lb_split = std::make_shared<load_balancing_split_transformer>(2, 0.5);
+			graph_generator ggen(2, tm, recorder.get_cb(), lb_split);
+			test_utils::mock_buffer_factory mbf(&tm, &ggen);
+			auto buf = mbf.create_buffer(cl::sycl::range<1>(300));
+
+			const auto add_task = [&] {
+				return build_and_flush(ggen, test_utils::add_compute_task<class UKN(task)>(tm,
+				                                 [&](handler& cgh) { buf.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+				                                 cl::sycl::range<1>{300}));
+			};
+
+			// Without any measurements, all nodes are assumed to be equally fast
+			const auto tid_a = add_task();
+			CHECK(get_node_range(tid_a, 0) == 150);
+			CHECK(get_node_range(tid_a, 1) == 150);
+
+			lb_split->report_throughput(0, 100, std::chrono::microseconds(100));
+			lb_split->report_throughput(1, 200, std::chrono::microseconds(100));
+			const auto tid_b = add_task();
+			CHECK(get_node_range(tid_b, 0) == 100);
+			CHECK(get_node_range(tid_b, 1) == 200);
+
+			// New measurements are damped
+			lb_split->report_throughput(0, 300, std::chrono::microseconds(100));
+			const auto tid_c = add_task();
+			CHECK(get_node_range(tid_c, 0) == 150);
+			CHECK(get_node_range(tid_c, 1) == 150);
+		}
+	}
+
+	TEST_CASE("split transformers respect the master node weight", "[graph_generator][transformer]") {
+		using namespace cl::sycl::access;
+		task_manager tm{true};
+		command_pkg_recorder recorder;
+
+		const auto get_node_range = [&](task_id tid, node_id nid) -> size_t {
+			const auto computes = recorder.get_pkgs(tid, nid, command::COMPUTE);
+			if(computes.empty()) return 0;
+			REQUIRE(computes.size() == 1);
+			return computes[0].data.compute.subrange.range[0];
+		};
+
+		const auto add_task = [&](graph_generator& ggen, test_utils::mock_buffer<1>& buf) {
+			return build_and_flush(ggen, test_utils::add_compute_task<class UKN(task)>(tm,
+			                                 [&](handler& cgh) { buf.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+			                                 cl::sycl::range<1>{250}));
+		};
+
+		SECTION("when the master node is excluded") {
+			graph_generator ggen(3, tm, recorder.get_cb(), std::make_shared<naive_split_transformer>(3, 1, 0.0));
+			test_utils::mock_buffer_factory mbf(&tm, &ggen);
+			auto buf = mbf.create_buffer(cl::sycl::range<1>(250));
+			const auto tid = add_task(ggen, buf);
+			CHECK(get_node_range(tid, 0) == 0);
+			CHECK(get_node_range(tid, 1) == 125);
+			CHECK(get_node_range(tid, 2) == 125);
+		}
+
+		SECTION("when the master node has a fractional weight") {
+			const auto naive_split = std::make_shared<naive_split_transformer>(3, 1, 0.5);
+			graph_generator ggen(3, tm, recorder.get_cb(), naive_split);
+			test_utils::mock_buffer_factory mbf(&tm, &ggen);
+			auto buf = mbf.create_buffer(cl::sycl::range<1>(250));
+			const auto tid_a = add_task(ggen, buf);
+			CHECK(get_node_range(tid_a, 0) == 50);
+			CHECK(get_node_range(tid_a, 1) == 100);
+			CHECK(get_node_range(tid_a, 2) == 100);
+
+			// The weight can be adjusted at any time (e.g. based on scheduler utilization)
+			naive_split->set_master_weight(1.0);
+			const auto tid_b = add_task(ggen, buf);
+			CHECK(get_node_range(tid_b, 0) == 83);
+			CHECK(get_node_range(tid_b, 1) == 83);
+			CHECK(get_node_range(tid_b, 2) == 84);
+		}
+
+		SECTION("when load balancing") {
+			const auto lb_split = std::make_shared<load_balancing_split_transformer>(3, 0.5);
+			lb_split->set_master_weight(0.5);
+			graph_generator ggen(3, tm, recorder.get_cb(), lb_split);
+			test_utils::mock_buffer_factory mbf(&tm, &ggen);
+			auto buf = mbf.create_buffer(cl::sycl::range<1>(250));
+			const auto tid = add_task(ggen, buf);
+			CHECK(get_node_range(tid, 0) == 50);
+			CHECK(get_node_range(tid, 1) == 100);
+			CHECK(get_node_range(tid, 2) == 100);
+		}
+	}
+
+	TEST_CASE("split transformers align chunk boundaries to the split granularity", "[graph_generator][transformer]") {
+		using namespace cl::sycl::access;
+		task_manager tm{true};
+		command_pkg_recorder recorder;
+
+		const auto get_node_range = [&](task_id tid, node_id nid) -> size_t {
+			const auto computes = recorder.get_pkgs(tid, nid, command::COMPUTE);
+			if(computes.empty()) return 0;
+			REQUIRE(computes.size() == 1);
+			return computes[0].data.compute.subrange.range[0];
+		};
+
+		SECTION("when a work-group size is forced") {
+			graph_generator ggen(3, tm, recorder.get_cb(), std::make_shared<naive_split_transformer>(3, 1, 1.0, 16));
+			test_utils::mock_buffer_factory mbf(&tm, &ggen);
+			auto buf = mbf.create_buffer(cl::sycl::range<1>(160));
+			const auto tid = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task)>(tm,
+			                                           [&](handler& cgh) { buf.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+			                                           cl::sycl::range<1>{160}));
+			// 10 work-groups are distributed as evenly as possible
+			CHECK(get_node_range(tid, 0) == 48);
+			CHECK(get_node_range(tid, 1) == 48);
+			CHECK(get_node_range(tid, 2) == 64);
+		}
+
+		SECTION("when the kernel provides a granularity hint") {
+			const auto lb_split = std::make_shared<load_balancing_split_transformer>(2, 0.5, std::vector<double>{1.0, 2.0});
+			graph_generator ggen(2, tm, recorder.get_cb(), lb_split);
+			test_utils::mock_buffer_factory mbf(&tm, &ggen);
+			auto buf = mbf.create_buffer(cl::sycl::range<1>(100));
+			const auto tid = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task)>(tm,
+			                                           [&](handler& cgh) {
+				                                           cgh.set_split_granularity(cl::sycl::range<1>(8));
+				                                           buf.get_access<mode::discard_write>(cgh, access::one_to_one<1>());
+			                                           },
+			                                           cl::sycl::range<1>{100}));
+			// The remainder that doesn't fill an entire granule is assigned to the last chunk
+			CHECK(get_node_range(tid, 0) == 32);
+			CHECK(get_node_range(tid, 1) == 68);
+		}
+	}
+
+	TEST_CASE("graph_generator fuses chains of compute tasks without data transfers", "[graph_generator][command-graph][task-fusion]") {
+		using namespace cl::sycl::access;
+		task_manager tm{true};
+		cdag_inspector inspector;
+		command_pkg_recorder recorder(inspector.get_cb());
+		graph_generator ggen(2, tm, recorder.get_cb(), nullptr, 4);
+		test_utils::mock_buffer_factory mbf(&tm, &ggen);
+		auto buf_a = mbf.create_buffer(cl::sycl::range<1>(100));
+		auto buf_b = mbf.create_buffer(cl::sycl::range<1>(100));
+
+		const auto tid_a = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_a)>(tm,
+		                                             [&](handler& cgh) { buf_a.get_access<mode::discard_write>(cgh, access::one_to_one<1>()); },
+		                                             cl::sycl::range<1>{100}));
+		const auto tid_b = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_b)>(tm,
+		                                             [&](handler& cgh) { buf_a.get_access<mode::read_write>(cgh, access::one_to_one<1>()); },
+		                                             cl::sycl::range<1>{100}));
+		const auto tid_c = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_c)>(tm,
+		                                             [&](handler& cgh) {
+			                                             buf_a.get_access<mode::read>(cgh, access::one_to_one<1>());
+			                                             buf_b.get_access<mode::discard_write>(cgh, access::one_to_one<1>());
+		                                             },
+		                                             cl::sycl::range<1>{100}));
+
+		// Nothing is flushed while the chain can still grow
+		CHECK(inspector.get_commands(boost::none, boost::none, boost::none).empty());
+
+		// Reading a neighborhood requires data transfers, so this task cannot be fused
+		const auto tid_d = build_and_flush(ggen, test_utils::add_compute_task<class UKN(task_d)>(tm,
+		                                             [&](handler& cgh) {
+			                                             buf_a.get_access<mode::read>(cgh, access::neighborhood<1>(1));
+			                                             buf_b.get_access<mode::discard_write>(cgh, access::one_to_one<1>());
+		                                             },
+		                                             cl::sycl::range<1>{100}));
+		ggen.flush_held_back();
+
+		CHECK(recorder.get_pkgs(tid_b, boost::none, boost::none).empty());
+		CHECK(recorder.get_pkgs(tid_c, boost::none, boost::none).empty());
+		for(node_id nid = 0; nid < 2; ++nid) {
+			const auto fused_computes = recorder.get_pkgs(tid_a, nid, command::COMPUTE);
+			REQUIRE(fused_computes.size() == 1);
+			const auto fused_cid = fused_computes[0].cid;
+			CHECK(fused_computes[0].data.compute.fused_tasks == 2);
+
+			// Dependencies onto fused commands are redirected to the command that executes them
+			const auto computes = recorder.get_pkgs(tid_d, nid, command::COMPUTE);
+			REQUIRE(computes.size() == 1);
+			CHECK(computes[0].data.compute.fused_tasks == 0);
+			CHECK(inspector.has_dependency(computes[0].cid, fused_cid));
+			const auto pushes = inspector.get_commands(tid_d, nid, command::PUSH);
+			REQUIRE(pushes.size() == 1);
+			CHECK(inspector.has_dependency(*pushes.cbegin(), fused_cid));
+		}
+
+		maybe_print_graph(tm);
+		maybe_print_graph(ggen);
+	}
+
 } // namespace detail
 } // namespace celerity
 
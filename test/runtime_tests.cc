@@ -1,6 +1,13 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <random>
+#include <thread>
 
 #define CATCH_CONFIG_MAIN
 #include <catch.hpp>
@@ -10,8 +17,15 @@
 #define CELERITY_TEST
 #include <celerity.h>
 
+#include "command_batch.h"
+#include "config.h"
+#include "executor.h"
 #include "ranges.h"
 #include "region_map.h"
+#include "rma_transport.h"
+#include "spsc_queue.h"
+#include "staging_buffer_pool.h"
+#include "transport.h"
 
 #include "test_utils.h"
 
@@ -390,6 +404,439 @@ TEST_CASE("tasks gracefully handle get_requirements() calls for buffers they don
 	}
 }
 
+TEST_CASE("executor admission control never holds back transfers behind other jobs", "[executor]") {
+	// The executor used to stop accepting new commands once 20 jobs were live. If all of those were waiting on data from another node,
+	// which itself was waiting on a PUSH from this node that was stuck in the command queue, both nodes would deadlock.
+	const detail::admission_control admission(4, 1024);
+	const size_t running_compute_jobs = 20;
+	REQUIRE(admission.admit(detail::command::PUSH, running_compute_jobs, 0));
+	REQUIRE(admission.admit(detail::command::AWAIT_PUSH, running_compute_jobs, 4096));
+	REQUIRE(admission.admit(detail::command::MASTER_ACCESS, running_compute_jobs, 4096));
+	REQUIRE_FALSE(admission.admit(detail::command::COMPUTE, running_compute_jobs, 0));
+
+	SECTION("compute jobs are bounded by device capacity") {
+		REQUIRE(admission.admit(detail::command::COMPUTE, 3, 0));
+		REQUIRE_FALSE(admission.admit(detail::command::COMPUTE, 4, 0));
+	}
+
+	SECTION("pushes are bounded by outgoing transfer bytes") {
+		REQUIRE(admission.admit(detail::command::PUSH, 0, 512));
+		REQUIRE_FALSE(admission.admit(detail::command::PUSH, 0, 1024));
+	}
+
+	SECTION("a push is always admitted if nothing else is being sent") {
+		const detail::admission_control no_budget(4, 0);
+		REQUIRE(no_budget.admit(detail::command::PUSH, 0, 0));
+	}
+}
+
+TEST_CASE("executor keeps starting other jobs while all compute jobs are stuck", "[executor]") {
+	// Once all compute slots are taken by jobs that can't make progress (here because their task hasn't been defined yet, in practice
+	// e.g. because they are waiting for data from another node), commands received afterwards must still be executed.
+	detail::logger test_logger("executor_test");
+	detail::config cfg(nullptr, nullptr, test_logger);
+	detail::task_manager tm{false};
+	detail::device_queue queue(test_logger);
+	queue.init(cfg, &tm, nullptr);
+	std::atomic<size_t> executed_count{0};
+	const auto master_tid = test_utils::add_master_access_task(tm, [&](handler&) { ++executed_count; });
+	// Task ids are assigned consecutively
+	const auto compute_tid = master_tid + 1;
+
+	const size_t max_compute_jobs = 2;
+	const auto net = std::make_shared<detail::loopback_transport::network>(1);
+	detail::executor exec(queue, tm, test_logger.create_context({{"test", "executor"}}), std::make_unique<detail::loopback_transport>(net, 0), nullptr,
+	    false, max_compute_jobs);
+	exec.enable_local_commands();
+	exec.startup();
+
+	// More compute commands than there are compute slots, followed by an independent master access
+	detail::command_id cid = 0;
+	for(; cid < 3 * max_compute_jobs; ++cid) {
+		detail::command_data compute_data{};
+		compute_data.compute = {detail::command_subrange(subrange<1>(static_cast<size_t>(cid), 1)), 0};
+		exec.enqueue_local_command(detail::command_pkg(compute_tid, cid, detail::command::COMPUTE, compute_data), {});
+	}
+	exec.enqueue_local_command(detail::command_pkg(master_tid, cid++, detail::command::MASTER_ACCESS, detail::command_data{}), {});
+	exec.end_local_flush();
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while(executed_count < 1 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+	REQUIRE(executed_count == 1);
+
+	// Now let the compute jobs finish
+	tm.create_compute_task([](handler& cgh) { cgh.parallel_for<class stuck_compute_kernel>(cl::sycl::range<1>(8), [](cl::sycl::id<1>) {}); });
+	REQUIRE(tm.has_task(compute_tid));
+	exec.enqueue_local_command(detail::command_pkg(0, std::numeric_limits<detail::command_id>::max(), detail::command::SHUTDOWN, detail::command_data{}), {});
+	exec.end_local_flush();
+	exec.shutdown();
+}
+
+TEST_CASE("executor only considers local commands for the completed watermark once their flush has ended", "[executor]") {
+	detail::logger test_logger("executor_test");
+	detail::task_manager tm{false};
+	detail::device_queue queue(test_logger);
+	std::atomic<size_t> executed_count{0};
+	const auto tid = test_utils::add_master_access_task(tm, [&](handler&) { ++executed_count; });
+
+	std::mutex watermarks_mutex;
+	std::vector<detail::command_id> watermarks;
+	const auto net = std::make_shared<detail::loopback_transport::network>(1);
+	detail::executor exec(queue, tm, test_logger.create_context({{"test", "executor"}}), std::make_unique<detail::loopback_transport>(net, 0), nullptr);
+	exec.enable_local_commands();
+	exec.set_completion_callback([&](detail::node_id, detail::command_id watermark) {
+		std::lock_guard<std::mutex> lock(watermarks_mutex);
+		watermarks.push_back(watermark);
+	});
+	exec.startup();
+
+	// Commands within a flush are not ordered by id (e.g. PUSHes are passed before the COMPUTEs of the same task)
+	exec.enqueue_local_command(detail::command_pkg(tid, 12, detail::command::MASTER_ACCESS, detail::command_data{}), {});
+	while(executed_count < 1) {
+		std::this_thread::yield();
+	}
+	// Give the executor some time to report the completion
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	{
+		std::lock_guard<std::mutex> lock(watermarks_mutex);
+		REQUIRE(std::all_of(watermarks.cbegin(), watermarks.cend(), [](detail::command_id watermark) { return watermark <= 10; }));
+	}
+
+	exec.enqueue_local_command(detail::command_pkg(tid, 10, detail::command::MASTER_ACCESS, detail::command_data{}), {});
+	exec.enqueue_local_command(detail::command_pkg(tid, 11, detail::command::MASTER_ACCESS, detail::command_data{}), {});
+	exec.end_local_flush();
+	exec.enqueue_local_command(detail::command_pkg(0, std::numeric_limits<detail::command_id>::max(), detail::command::SHUTDOWN, detail::command_data{}), {});
+	exec.end_local_flush();
+	exec.shutdown();
+
+	REQUIRE(executed_count == 3);
+	REQUIRE(!watermarks.empty());
+	REQUIRE(watermarks.back() == 13);
+}
+
+TEST_CASE("executors of simulated nodes exchange commands and progress reports over a loopback_transport", "[executor][transport]") {
+	detail::logger test_logger("executor_test");
+	detail::task_manager tm{false};
+	detail::device_queue queue(test_logger);
+	std::atomic<size_t> executed_count{0};
+	const auto tid = test_utils::add_master_access_task(tm, [&](handler&) { ++executed_count; });
+
+	const auto net = std::make_shared<detail::loopback_transport::network>(2);
+	const auto execution_logger = test_logger.create_context({{"test", "executor"}});
+	detail::executor master_exec(queue, tm, execution_logger, std::make_unique<detail::loopback_transport>(net, 0), nullptr);
+	detail::executor worker_exec(queue, tm, execution_logger, std::make_unique<detail::loopback_transport>(net, 1), nullptr);
+	master_exec.enable_local_commands();
+	// Only invoked on the master's executor thread
+	std::vector<std::pair<detail::node_id, detail::command_id>> watermarks;
+	master_exec.set_completion_callback([&](detail::node_id nid, detail::command_id watermark) { watermarks.emplace_back(nid, watermark); });
+	master_exec.startup();
+	worker_exec.startup();
+
+	// This plays the role of the scheduler on the master node
+	detail::loopback_transport scheduler_transport(net, 0);
+	const detail::command_pkg shutdown(0, std::numeric_limits<detail::command_id>::max(), detail::command::SHUTDOWN, detail::command_data{});
+	detail::command_batch batch;
+	batch.add(detail::command_pkg(tid, 1, detail::command::MASTER_ACCESS, detail::command_data{}), {});
+	batch.add(detail::command_pkg(tid, 2, detail::command::MASTER_ACCESS, detail::command_data{}), {1});
+	batch.add(shutdown, {});
+	scheduler_transport.send(1, detail::transport::channel::COMMANDS, batch.take_data());
+	worker_exec.shutdown();
+	REQUIRE(executed_count == 2);
+
+	// The worker's progress reports have been sent by now, and are received by the master before it shuts down
+	master_exec.enqueue_local_command(shutdown, {});
+	master_exec.end_local_flush();
+	master_exec.shutdown();
+
+	REQUIRE(!watermarks.empty());
+	REQUIRE(watermarks.back() == std::make_pair(detail::node_id(1), detail::command_id(3)));
+}
+
+TEST_CASE("config parses split weights separated by arbitrary whitespace", "[config]") {
+	// Unsets the variable if value is null
+	const auto set_env = [](const char* key, const char* value) {
+#ifdef _MSC_VER
+		_putenv_s(key, value != nullptr ? value : "");
+#else
+		if(value != nullptr) {
+			setenv(key, value, 1);
+		} else {
+			unsetenv(key);
+		}
+#endif
+	};
+	detail::logger test_logger("config_test");
+
+	set_env("CELERITY_SPLIT_WEIGHTS", " 1   2.5\t 0  ");
+	const detail::config cfg(nullptr, nullptr, test_logger);
+	const auto weights = cfg.get_split_weights();
+	REQUIRE(weights.is_initialized());
+	REQUIRE(*weights == std::vector<double>{1.0, 2.5, 0.0});
+
+	set_env("CELERITY_SPLIT_WEIGHTS", "1  x 2");
+	const detail::config invalid_cfg(nullptr, nullptr, test_logger);
+	REQUIRE_FALSE(invalid_cfg.get_split_weights().is_initialized());
+
+	set_env("CELERITY_SPLIT_WEIGHTS", "0 0");
+	const detail::config zero_cfg(nullptr, nullptr, test_logger);
+	REQUIRE_FALSE(zero_cfg.get_split_weights().is_initialized());
+
+	set_env("CELERITY_SPLIT_WEIGHTS", nullptr);
+}
+
+TEST_CASE("command_batch preserves commands and their dependencies", "[command_batch]") {
+	detail::command_batch batch;
+	REQUIRE(batch.empty());
+
+	detail::command_data compute_data{};
+	compute_data.compute = {detail::command_subrange(subrange<1>(5, 10)), 0};
+	batch.add(detail::command_pkg(3, 10, detail::command::COMPUTE, compute_data), {});
+	batch.add(detail::command_pkg(4, 11, detail::command::MASTER_ACCESS, detail::command_data{}), {10, 7, 2});
+	batch.add(detail::command_pkg(4, 12, detail::command::MASTER_ACCESS, detail::command_data{}), {11});
+	REQUIRE(batch.get_command_count() == 3);
+
+	const auto data = batch.take_data();
+	REQUIRE(batch.empty());
+	REQUIRE(batch.get_command_count() == 0);
+
+	std::vector<detail::command_id> cids;
+	std::vector<std::vector<detail::command_id>> dependencies;
+	std::vector<detail::command_id> dependency_buffer;
+	detail::command_batch::decode(
+	    data.data(), data.size(), dependency_buffer, [&](const detail::command_pkg& pkg, const std::vector<detail::command_id>& deps) {
+		    cids.push_back(pkg.cid);
+		    dependencies.push_back(deps);
+		    if(pkg.cid == 10) {
+			    REQUIRE(pkg.tid == 3);
+			    REQUIRE(pkg.cmd == detail::command::COMPUTE);
+			    REQUIRE(pkg.data.compute.subrange == detail::command_subrange(subrange<1>(5, 10)));
+		    }
+	    });
+	REQUIRE(cids == std::vector<detail::command_id>{10, 11, 12});
+	REQUIRE(dependencies == std::vector<std::vector<detail::command_id>>{{}, {10, 7, 2}, {11}});
+}
+
+TEST_CASE("command_batch encodes commands compactly", "[command_batch]") {
+	detail::command_batch batch;
+	detail::command_data await_push_data{};
+	await_push_data.await_push = {5, 2, 1000, detail::command_subrange(subrange<2>({0, 64}, {128, 64}))};
+	batch.add(detail::command_pkg(100, 1003, detail::command::AWAIT_PUSH, await_push_data), {998, 1001});
+	const detail::command_id shutdown_cid = std::numeric_limits<detail::command_id>::max() - 1;
+	batch.add(detail::command_pkg(0, shutdown_cid, detail::command::SHUTDOWN, detail::command_data{}), {});
+
+	// The fixed-size representation would be two command_pkgs plus 64-bit dependency ids
+	const auto data = batch.take_data();
+	REQUIRE(data.size() < sizeof(detail::command_pkg));
+
+	std::vector<detail::command_pkg> pkgs;
+	std::vector<detail::command_id> dependency_buffer;
+	detail::command_batch::decode(
+	    data.data(), data.size(), dependency_buffer, [&](const detail::command_pkg& pkg, const std::vector<detail::command_id>& deps) {
+		    if(pkg.cmd == detail::command::AWAIT_PUSH) { REQUIRE(deps == std::vector<detail::command_id>{998, 1001}); }
+		    pkgs.push_back(pkg);
+	    });
+	REQUIRE(pkgs.size() == 2);
+	REQUIRE(pkgs[0].tid == 100);
+	REQUIRE(pkgs[0].cid == 1003);
+	REQUIRE(pkgs[0].data.await_push.bid == 5);
+	REQUIRE(pkgs[0].data.await_push.source == 2);
+	REQUIRE(pkgs[0].data.await_push.source_cid == 1000);
+	REQUIRE(pkgs[0].data.await_push.subrange == detail::command_subrange(subrange<2>({0, 64}, {128, 64})));
+	REQUIRE(pkgs[1].cmd == detail::command::SHUTDOWN);
+	REQUIRE(pkgs[1].cid == shutdown_cid);
+}
+
+TEST_CASE("spsc_queue passes elements between threads in order", "[spsc_queue]") {
+	detail::spsc_queue<std::vector<size_t>> queue(3);
+	REQUIRE(queue.get_capacity() == 4);
+
+	SECTION("try_push fails without consuming the element if the queue is full") {
+		for(size_t i = 0; i < 4; ++i) {
+			std::vector<size_t> value{i};
+			REQUIRE(queue.try_push(value));
+		}
+		std::vector<size_t> value{4};
+		REQUIRE_FALSE(queue.try_push(value));
+		REQUIRE(value == std::vector<size_t>{4});
+
+		std::vector<size_t> result;
+		REQUIRE(queue.try_pop(result));
+		REQUIRE(result == std::vector<size_t>{0});
+		REQUIRE(queue.try_push(value));
+	}
+
+	SECTION("elements pushed by a producer thread are popped in order by the consumer") {
+		constexpr size_t count = 10000;
+		std::thread producer([&queue]() {
+			for(size_t i = 0; i < count; ++i) {
+				std::vector<size_t> value{i, i + 1};
+				while(!queue.try_push(value)) {
+					std::this_thread::yield();
+				}
+			}
+		});
+		std::vector<size_t> result;
+		for(size_t i = 0; i < count; ++i) {
+			while(!queue.try_pop(result)) {
+				std::this_thread::yield();
+			}
+			REQUIRE(result == std::vector<size_t>{i, i + 1});
+		}
+		producer.join();
+		REQUIRE_FALSE(queue.try_pop(result));
+	}
+}
+
+TEST_CASE("rma_transport delivers messages in allocation order even if their puts complete out of order", "[rma_transport]") {
+	// The test process is the only node, so it sends to itself
+	detail::rma_transport rma(4096);
+	const int first = 1;
+	const int second = 2;
+	const auto e1 = rma.allocate(0, sizeof(int));
+	const auto e2 = rma.allocate(0, sizeof(int));
+	REQUIRE(e1.is_valid());
+	REQUIRE(e2.is_valid());
+
+	std::vector<int> received;
+	const auto consume = [&received](const char* message) {
+		int value;
+		std::memcpy(&value, message, sizeof(int));
+		received.push_back(value);
+	};
+
+	MPI_Request request;
+	rma.put(e2, &second, &request);
+	MPI_Wait(&request, MPI_STATUS_IGNORE);
+	rma.publish(e2);
+	// The second entry must not become visible before the first one
+	REQUIRE_FALSE(rma.poll(consume));
+
+	rma.put(e1, &first, &request);
+	MPI_Wait(&request, MPI_STATUS_IGNORE);
+	rma.publish(e1);
+	REQUIRE(rma.poll(consume));
+	REQUIRE(received == std::vector<int>{first, second});
+
+	// The consumed space can be reused for further messages
+	for(int i = 0; i < 1000; ++i) {
+		const auto e = rma.allocate(0, sizeof(int));
+		REQUIRE(e.is_valid());
+		rma.put(e, &i, &request);
+		MPI_Wait(&request, MPI_STATUS_IGNORE);
+		rma.publish(e);
+		REQUIRE(rma.poll(consume));
+		REQUIRE(received.back() == i);
+	}
+}
+
+TEST_CASE("loopback_transport delivers messages between simulated nodes", "[transport]") {
+	constexpr size_t num_nodes = 4;
+	const auto net = std::make_shared<detail::loopback_transport::network>(num_nodes);
+
+	SECTION("messages are only received by their target, on the channel they were sent on") {
+		detail::loopback_transport t0(net, 0);
+		detail::loopback_transport t1(net, 1);
+		REQUIRE(t1.get_local_nid() == 1);
+		REQUIRE(t1.get_num_nodes() == num_nodes);
+
+		t0.send(1, detail::transport::channel::COMMANDS, {1, 2, 3});
+		t1.send(0, detail::transport::channel::PROGRESS_REPORTS, {4});
+		REQUIRE(t0.get_pending_send_count() == 0);
+
+		detail::node_id source;
+		std::vector<unsigned char> message;
+		REQUIRE_FALSE(t0.try_receive(detail::transport::channel::COMMANDS, source, message));
+		REQUIRE_FALSE(t1.try_receive(detail::transport::channel::PROGRESS_REPORTS, source, message));
+		REQUIRE(t1.try_receive(detail::transport::channel::COMMANDS, source, message));
+		REQUIRE(source == 0);
+		REQUIRE(message == std::vector<unsigned char>{1, 2, 3});
+		REQUIRE(t0.try_receive(detail::transport::channel::PROGRESS_REPORTS, source, message));
+		REQUIRE(source == 1);
+		REQUIRE(message == std::vector<unsigned char>{4});
+	}
+
+	SECTION("command batches sent by concurrent nodes arrive in order per source") {
+		constexpr size_t batches_per_target = 1000;
+		// Catch assertions are not thread safe, so each node just records what it received
+		std::vector<std::vector<detail::command_id>> received_cids(num_nodes * num_nodes);
+		std::vector<std::thread> nodes;
+		for(size_t n = 0; n < num_nodes; ++n) {
+			nodes.emplace_back([&, n]() {
+				detail::loopback_transport t(net, n);
+				for(size_t i = 0; i < batches_per_target; ++i) {
+					for(detail::node_id target = 0; target < num_nodes; ++target) {
+						detail::command_batch batch;
+						batch.add(detail::command_pkg(0, n * batches_per_target + i, detail::command::MASTER_ACCESS, detail::command_data{}), {});
+						t.send(target, detail::transport::channel::COMMANDS, batch.take_data());
+					}
+				}
+				detail::node_id source;
+				std::vector<unsigned char> message;
+				std::vector<detail::command_id> dependencies;
+				for(size_t received = 0; received < num_nodes * batches_per_target;) {
+					if(!t.try_receive(detail::transport::channel::COMMANDS, source, message)) {
+						std::this_thread::yield();
+						continue;
+					}
+					auto& from_source = received_cids[n * num_nodes + source];
+					detail::command_batch::decode(message.data(), message.size(), dependencies,
+					    [&](const detail::command_pkg& pkg, const std::vector<detail::command_id>&) { from_source.push_back(pkg.cid); });
+					++received;
+				}
+			});
+		}
+		for(auto& t : nodes) {
+			t.join();
+		}
+
+		for(size_t n = 0; n < num_nodes; ++n) {
+			for(size_t source = 0; source < num_nodes; ++source) {
+				std::vector<detail::command_id> expected(batches_per_target);
+				for(size_t i = 0; i < batches_per_target; ++i) {
+					expected[i] = source * batches_per_target + i;
+				}
+				REQUIRE(received_cids[n * num_nodes + source] == expected);
+			}
+		}
+	}
+}
+
+TEST_CASE("staging_buffer_pool recycles blocks by size class", "[staging_buffer_pool]") {
+	using pool = detail::staging_buffer_pool;
+
+	SECTION("sizes are rounded up to one of four size classes per power of two") {
+		CHECK(pool::get_size_class(1) == std::make_pair(size_t(0), size_t(4096)));
+		CHECK(pool::get_size_class(4096) == std::make_pair(size_t(0), size_t(4096)));
+		CHECK(pool::get_size_class(4097) == std::make_pair(size_t(1), size_t(5120)));
+		CHECK(pool::get_size_class(8192) == std::make_pair(size_t(4), size_t(8192)));
+		CHECK(pool::get_size_class(8193) == std::make_pair(size_t(5), size_t(10240)));
+		for(size_t size = 1; size < 1024 * 1024; size = size * 3 / 2 + 1) {
+			const auto size_class = pool::get_size_class(size);
+			CHECK(size_class.second >= size);
+			CHECK(size_class.second <= std::max(size_t(4096), size + size / 4));
+			CHECK(pool::get_size_class(size_class.second) == size_class);
+		}
+	}
+
+	SECTION("freed blocks are reused for allocations of the same size class") {
+		void* block = nullptr;
+		{
+			detail::staging_buffer buf(100 * 1000);
+			block = buf.get();
+		}
+		{
+			detail::staging_buffer buf(100 * 1024);
+			REQUIRE(buf.get() == block);
+			detail::staging_buffer other(100 * 1024);
+			REQUIRE(other.get() != block);
+		}
+		detail::staging_buffer smaller(50 * 1000);
+		REQUIRE(smaller.get() != block);
+	}
+}
+
 TEST_CASE("safe command group functions must not capture by reference", "[lifetime][dx]") {
 	int value = 123;
 	const auto unsafe = [&]() { return value + 1; };